@@ -0,0 +1,123 @@
+// Copyright (C) 2022 Petter Nilsson. MIT License.
+
+/**
+ * @file Compare the augmented Lagrangian NLP solver with Ipopt on the SE(2) optimal control problem.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include <gflags/gflags.h>
+#include <smooth/feedback/compat/ipopt.hpp>
+#include <smooth/feedback/nlp_solver.hpp>
+#include <smooth/feedback/ocp_flatten.hpp>
+#include <smooth/feedback/ocp_to_nlp.hpp>
+
+#include "ocp_se2.hpp"
+
+DEFINE_uint64(batch, 10, "Number of solves per solver");
+DEFINE_uint64(intervals, 8, "Number of mesh intervals");
+DEFINE_uint64(degree, 5, "Polynomial degree in each mesh interval");
+DEFINE_double(tol, 1e-6, "Optimality tolerance");
+DEFINE_bool(verbose, false, "Print per solve information");
+
+struct NLPBatchResult
+{
+  std::size_t num_optimal{0};
+  double total_duration{0};
+  double min_duration{std::numeric_limits<double>::infinity()};
+  double max_duration{0};
+  smooth::feedback::NLPSolution last{};
+};
+
+template<typename Solve>
+NLPBatchResult run_batch(const std::string & name, Solve && solve)
+{
+  NLPBatchResult ret;
+
+  for (auto i = 0u; i != FLAGS_batch; ++i) {
+    const auto t0 = std::chrono::high_resolution_clock::now();
+    ret.last      = solve();
+    const auto t1 = std::chrono::high_resolution_clock::now();
+
+    const double duration = std::chrono::duration<double>(t1 - t0).count();
+
+    if (ret.last.status == smooth::feedback::NLPSolution::Status::Optimal) { ++ret.num_optimal; }
+    ret.total_duration += duration;
+    ret.min_duration = std::min(duration, ret.min_duration);
+    ret.max_duration = std::max(duration, ret.max_duration);
+
+    if (FLAGS_verbose) {
+      std::cout << std::setw(30) << name + " solve " << i << ": status " << static_cast<int>(ret.last.status)
+                << ", " << ret.last.iter << " iterations, " << duration << "s" << '\n';
+    }
+  }
+
+  return ret;
+}
+
+int main(int argc, char ** argv)
+{
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  const auto xl = []<typename T>(T) -> X<T> { return X<T>::Identity(); };
+  const auto ul = []<typename T>(T) -> U<T> { return Eigen::Vector2<T>::Constant(0.01); };
+
+  const auto flatocp = smooth::feedback::flatten_ocp(ocp_se2, xl, ul);
+
+  const smooth::feedback::Mesh<5, 10> mesh(FLAGS_intervals, FLAGS_degree);
+
+  auto nlp = smooth::feedback::ocp_to_nlp<smooth::diff::Type::Analytic>(flatocp, mesh);
+
+  std::cout << "SE(2) OCP: " << mesh.N_ivals() << " intervals, " << mesh.N_colloc() << " collocation points, "
+            << nlp.n() << " variables, " << nlp.m() << " constraints" << '\n';
+
+  const auto ipopt = run_batch("Ipopt", [&] {
+    return smooth::feedback::solve_nlp_ipopt(
+      nlp,
+      std::nullopt,
+      {{"print_level", 0}},
+      {{"linear_solver", "mumps"}, {"hessian_approximation", "limited-memory"}},
+      {{"tol", FLAGS_tol}});
+  });
+
+  // working memory is allocated once
+  smooth::feedback::NLPSolver solver(nlp.n(), nlp.m(), {.eps_abs = FLAGS_tol, .delta_abs = FLAGS_tol});
+  const auto alm = run_batch("ALM", [&] { return solver.solve(nlp); });
+
+  using std::cout, std::setw;
+
+  cout << "-----------------------------------------------------------------" << '\n';
+  cout << "ALM (A) vs. Ipopt (B)" << '\n';
+  cout << "-----------------------------------------------------------------" << '\n';
+
+  cout << setw(30) << "Total number of solves: " << FLAGS_batch << '\n';
+
+  cout << setw(30) << "ALM optimal: " << alm.num_optimal << '\n';
+  cout << setw(30) << "Ipopt optimal: " << ipopt.num_optimal << '\n';
+
+  cout << setw(30) << "ALM iterations: " << alm.last.iter << '\n';
+  cout << setw(30) << "Ipopt iterations: " << ipopt.last.iter << '\n';
+
+  cout << setw(30) << "ALM avg duration: " << alm.total_duration / FLAGS_batch << '\n';
+  cout << setw(30) << "Ipopt avg duration: " << ipopt.total_duration / FLAGS_batch << '\n';
+
+  cout << setw(30) << "ALM min duration: " << alm.min_duration << '\n';
+  cout << setw(30) << "Ipopt min duration: " << ipopt.min_duration << '\n';
+
+  cout << setw(30) << "ALM max duration: " << alm.max_duration << '\n';
+  cout << setw(30) << "Ipopt max duration: " << ipopt.max_duration << '\n';
+
+  cout << setw(30) << "Avg duration ratio " << alm.total_duration / ipopt.total_duration << '\n';
+
+  cout << setw(30) << "ALM objective " << alm.last.objective << '\n';
+  cout << setw(30) << "Ipopt objective " << ipopt.last.objective << '\n';
+  cout << setw(30) << "Primal diff " << (alm.last.x - ipopt.last.x).norm() << '\n';
+
+  return EXIT_SUCCESS;
+}
@@ -7,9 +7,9 @@
 #include <chrono>
 #include <iostream>
 
-#include <smooth/feedback/collocation/dyn_error.hpp>
 #include <smooth/feedback/compat/ipopt.hpp>
 #include <smooth/feedback/ocp_flatten.hpp>
+#include <smooth/feedback/ocp_refine.hpp>
 #include <smooth/feedback/ocp_to_nlp.hpp>
 
 #include "ocp_se2.hpp"
@@ -32,30 +32,16 @@ int main()
   // std::cout << "TESTING FLAT DERIVATIVES\n";
   // smooth::feedback::test_ocp_derivatives(flatocp);
 
-  // target optimality
-  const double target_err = 1e-6;
-
   // define mesh
   smooth::feedback::Mesh<5, 10> mesh;
 
   // declare solution variable
   std::vector<typename decltype(ocp_se2)::Solution> sols;
-  std::optional<smooth::feedback::NLPSolution> nlpsol;
-
-  const auto t0 = std::chrono::high_resolution_clock::now();
-
-  for (auto iter = 0u; iter < 10; ++iter) {
-    std::cout << "---------- ITERATION " << iter << " ----------" << std::endl;
-    std::cout << "mesh: " << mesh.N_ivals() << " intervals, " << mesh.N_colloc() << " collocation pts" << std::endl;
-
-    // transcribe optimal control problem to nonlinear programming problem
-    auto nlp = smooth::feedback::ocp_to_nlp<smooth::diff::Type::Analytic>(flatocp, mesh);
 
-    // solve nonlinear programming problem
-    std::cout << "solving..." << std::endl;
-    nlpsol = smooth::feedback::solve_nlp_ipopt(
-      std::move(nlp),
-      nlpsol,
+  const auto solver = [](auto & nlp, const std::optional<smooth::feedback::NLPSolution> & warmstart) {
+    return smooth::feedback::solve_nlp_ipopt(
+      nlp,
+      warmstart,
       {
         {"print_level", 5},
       },
@@ -68,30 +54,26 @@ int main()
       {
         {"tol", 1e-6},
       });
+  };
 
-    // convert solution of nlp insto solution of ocp_se2
-    auto flatsol = smooth::feedback::nlpsol_to_ocpsol(flatocp, mesh, nlpsol.value());
-
-    // store unflattened solution
-    sols.push_back(smooth::feedback::unflatten_ocpsol<X<double>, U<double>>(flatsol, xl, ul));
-
-    // calculate errors
-    mesh.increase_degrees();
-    auto errs = smooth::feedback::mesh_dyn_error(flatocp.f, mesh, flatsol.t0, flatsol.tf, flatsol.x, flatsol.u);
-    mesh.decrease_degrees();
-
-    std::cout << "interval errors " << errs.transpose() << std::endl;
+  const auto t0 = std::chrono::high_resolution_clock::now();
 
-    if (errs.maxCoeff() > target_err) {
-      mesh.refine_errors(errs, 0.1 * target_err);
-      nlpsol = smooth::feedback::ocpsol_to_nlpsol(flatocp, mesh, flatsol);
-    } else {
-      break;
-    }
-  }
+  // solve and refine mesh until target optimality is reached
+  const auto res = smooth::feedback::solve_ocp_refine<smooth::diff::Type::Analytic>(
+    flatocp,
+    mesh,
+    solver,
+    {.target_err = 1e-6, .max_iter = 10, .n_threads = 4, .verbose = true},
+    {},
+    [&](std::size_t, const auto &, const auto & flatsol, const Eigen::VectorXd & errs) {
+      std::cout << "interval errors " << errs.transpose() << std::endl;
+      // store unflattened solution
+      sols.push_back(smooth::feedback::unflatten_ocpsol<X<double>, U<double>>(flatsol, xl, ul));
+    });
 
   const auto dur = std::chrono::high_resolution_clock::now() - t0;
 
+  std::cout << "converged: " << res.converged << " after " << res.iter << " iterations" << std::endl;
   std::cout << "TOTAL TIME: " << std::chrono::duration_cast<std::chrono::milliseconds>(dur).count() << "ms"
             << std::endl;
 
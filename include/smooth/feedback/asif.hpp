@@ -2,12 +2,18 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <optional>
+#include <span>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include "asif_func.hpp"
 #include "qp_solver.hpp"
 #include "time.hpp"
+#include "utils/thread_pool.hpp"
 
 namespace smooth::feedback {
 
@@ -29,18 +35,47 @@ struct ASIFilterParams
   ASIFtoQPParams asif{};
   /// solve_qp() parameters
   QPSolverParams qp{};
+  /// if set, barrier constraints are screened with this safety factor before solving (see asif_qp_screen())
+  std::optional<double> screen_factor{};
+  /// maximal number of barrier constraints in the screened QP (the full QP is solved if more are kept)
+  std::size_t screen_max_rows{4};
+  /// try to solve the QP in closed form before calling the QP solver (see asif_qp_closed_form())
+  bool closed_form{false};
 };
 
 /**
  * @brief ASI Filter
  *
- * Thin wrapper around asif_to_qp() and solve_qp() that keeps track of the most
+ * Thin wrapper around asif_to_qp() and QPSolver that keeps track of the most
  * recent solution for warmstarting, and facilitates working with time-varying
  * problems.
+ *
+ * The QP and the QP solver working memory are allocated at construction.
+ *
+ * If ASIFilterParams::screen_factor is set, barrier constraints with a large margin are left out and a reduced QP
+ * with at most ASIFilterParams::screen_max_rows barrier constraints is solved. The full QP is solved instead if too
+ * many constraints are kept, or if the reduced solution violates an omitted constraint.
+ *
+ * If ASIFilterParams::closed_form is set, QPs with at most one active barrier constraint are solved exactly
+ * without iterating.
+ *
+ * @tparam G state space
+ * @tparam U input space
+ * @tparam Dyn dynamics type
+ * @tparam DT differentiation method
+ * @tparam M number of QP constraints \f$ K n_h + n_{u, ineq} + 1 \f$ where \f$ n_{u, ineq} \f$ is the number of
+ * rows in the input bounds. If set (i.e. not -1) the QP, the QP solver working memory, and the warmstart use
+ * static-size matrices.
  */
-template<LieGroup G, Manifold U, typename Dyn, diff::Type DT = diff::Type::Default>
+template<LieGroup G, Manifold U, typename Dyn, diff::Type DT = diff::Type::Default, Eigen::Index M = -1>
 class ASIFilter
 {
+  /// @brief Number of QP variables
+  static constexpr Eigen::Index N = Dof<U> + 1;
+
+  /// @brief QP type
+  using QP = QuadraticProgram<M, N, double>;
+
 public:
   /**
    * @brief Construct an ASI filter
@@ -56,10 +91,36 @@ public:
   /**
    * @brief Construct an ASI filter (rvalue version).
    */
-  ASIFilter(Dyn && f, ASIFilterParams<U> && prm = ASIFilterParams<U>{}) : f_(std::move(f)), prm_(std::move(prm))
+  ASIFilter(Dyn && f, ASIFilterParams<U> && prm = ASIFilterParams<U>{})
+      : f_(std::move(f)), prm_(std::move(prm)), qp_solver_(prm_.qp), qp_red_solver_(prm_.qp)
   {
+    pbm_.T    = prm_.T;
+    pbm_.W_u  = prm_.u_weight;
+    pbm_.ulim = prm_.ulim;
+
+    if (prm_.asif.backup_reuse_threshold > 0) {
+      backup_.xs.resize(prm_.asif.K, Default<G>());
+      backup_.Ss.resize(prm_.asif.K);
+    }
+
     const int nu_ineq = prm_.ulim.A.rows();
     asif_to_qp_allocate<G, U>(qp_, prm_.asif.K, nu_ineq, prm_.nh);
+    qp_solver_.analyze(qp_);
+    cf_sol_ = qp_solver_.sol();
+
+    if (prm_.screen_factor.has_value()) {
+      const auto M_red = static_cast<Eigen::Index>(prm_.screen_max_rows) + nu_ineq + 1;
+      qp_red_.A.setZero(M_red, N);
+      qp_red_.l.setZero(M_red);
+      qp_red_.u.setZero(M_red);
+      qp_red_.P.setZero(N, N);
+      qp_red_.q.setZero(N);
+      qp_red_solver_.analyze(qp_red_);
+
+      ws_red_.primal.setZero(N);
+      ws_red_.dual.setZero(M_red);
+      kept_.reserve(prm_.screen_max_rows);
+    }
   }
 
   /**
@@ -77,6 +138,9 @@ public:
    * \f$\tau\f$ is \f$ S(\tau) = \{ h(\tau - t) \geq 0 \} \f$, and the backup controll action is \f$
    * u(\tau, x) = bu(\tau - t, x ) \f$.
    *
+   * @note If ASIFtoQPParams::backup_reuse_threshold is positive the backup trajectory from a previous call is
+   * re-used for nearby states, which requires that bu does not change between calls.
+   *
    * @returns {u, code}: safe control input and QP solver code
    */
   std::pair<U, QPSolutionStatus> operator()(const G & g, const U & u_des, auto && h, auto && bu)
@@ -85,28 +149,199 @@ public:
 
     assert((prm_.nh == std::invoke_result_t<decltype(h), Scalar<G>, G>::RowsAtCompileTime));
 
-    ASIFProblem<G, U> pbm{
-      .T     = prm_.T,
-      .x0    = g,
-      .u_des = u_des,
-      .W_u   = prm_.u_weight,
-      .ulim  = prm_.ulim,
-    };
+    pbm_.x0    = g;
+    pbm_.u_des = u_des;
+
+    asif_to_qp_update<G, U, DT>(
+      qp_,
+      pbm_,
+      prm_.asif,
+      f_,
+      std::forward<decltype(h)>(h),
+      std::forward<decltype(bu)>(bu),
+      prm_.asif.backup_reuse_threshold > 0 ? &backup_ : nullptr);
+
+    const auto n_bar = static_cast<Eigen::Index>(prm_.asif.K * prm_.nh);
+    closed_form_ = prm_.closed_form && asif_qp_closed_form(qp_, n_bar, cf_sol_, static_cast<double>(prm_.qp.eps_abs));
+    if (closed_form_) {
+      warmstart_ = cf_sol_;
+      return {rplus(u_des, cf_sol_.primal.template head<Dof<U>>()), cf_sol_.code};
+    }
 
-    asif_to_qp_update<G, U, DT>(qp_, pbm, prm_.asif, f_, std::forward<decltype(h)>(h), std::forward<decltype(bu)>(bu));
-    auto sol = feedback::solve_qp(qp_, prm_.qp, warmstart_);
+    if (prm_.screen_factor.has_value() && solve_screened()) {
+      return {rplus(u_des, warmstart_->primal.template head<Dof<U>>()), warmstart_->code};
+    }
+
+    const auto & sol = qp_solver_.solve(qp_, warmstart_);
 
     if (sol.code == QPSolutionStatus::Optimal) { warmstart_ = sol; }
 
     return {rplus(u_des, sol.primal.template head<Dof<U>>()), sol.code};
   }
 
+  /// @brief True if the QP in the most recent call was solved in closed form
+  bool closed_form() const { return closed_form_; }
+
 private:
+  /**
+   * @brief Screen barrier constraints and solve the reduced QP.
+   *
+   * On success the solution is mapped back to the full QP and stored in warmstart_.
+   *
+   * @return true if the reduced QP was solved and the solution satisfies all barrier constraints
+   */
+  bool solve_screened()
+  {
+    const auto n_bar = static_cast<Eigen::Index>(prm_.asif.K * prm_.nh);
+    const auto n_oth = qp_.A.rows() - n_bar;
+
+    if (!asif_qp_screen(qp_, qp_red_, n_bar, prm_.screen_factor.value(), kept_)) { return false; }
+
+    // map warmstart dual from full QP to reduced QP
+    std::optional<std::reference_wrapper<const QPSolution<-1, N, double>>> ws_red;
+    if (warmstart_.has_value()) {
+      ws_red_.primal = warmstart_->primal;
+      ws_red_.dual.setZero();
+      for (auto j = 0u; j < kept_.size(); ++j) { ws_red_.dual(j) = warmstart_->dual(kept_[j]); }
+      ws_red_.dual.tail(n_oth) = warmstart_->dual.tail(n_oth);
+      ws_red = std::cref(ws_red_);
+    }
+
+    const auto & sol = qp_red_solver_.solve(qp_red_, ws_red);
+
+    if (sol.code != QPSolutionStatus::Optimal) { return false; }
+    if (!asif_qp_screen_check(qp_, n_bar, sol.primal, static_cast<double>(prm_.qp.eps_abs))) { return false; }
+
+    // map dual from reduced QP to full QP (omitted constraints are inactive)
+    if (!warmstart_.has_value()) { warmstart_ = qp_solver_.sol(); }
+    warmstart_->code      = sol.code;
+    warmstart_->iter      = sol.iter;
+    warmstart_->primal    = sol.primal;
+    warmstart_->objective = sol.objective;
+    warmstart_->dual.setZero();
+    for (auto j = 0u; j < kept_.size(); ++j) { warmstart_->dual(kept_[j]) = sol.dual(j); }
+    warmstart_->dual.tail(n_oth) = sol.dual.tail(n_oth);
+
+    return true;
+  }
+
   Dyn f_;
 
-  QuadraticProgram<-1, -1, double> qp_;
+  QP qp_;
   ASIFilterParams<U> prm_;
-  std::optional<QPSolution<-1, -1, double>> warmstart_;
+  ASIFProblem<G, U> pbm_;
+  QPSolver<QP> qp_solver_;
+  std::optional<QPSolution<M, N, double>> warmstart_;
+  ASIFBackupTrajectory<G> backup_;
+  QPSolution<M, N, double> cf_sol_;
+  bool closed_form_{false};
+
+  QuadraticProgram<-1, N, double> qp_red_;
+  QPSolver<QuadraticProgram<-1, N, double>> qp_red_solver_;
+  QPSolution<-1, N, double> ws_red_;
+  std::vector<Eigen::Index> kept_;
+};
+
+/**
+ * @brief Filtered inputs from ASIFilterBatch in structure-of-arrays form.
+ */
+template<Manifold U>
+struct ASIFBatchResult
+{
+  /// safe control input for every agent
+  std::vector<U> u;
+  /// QP solver code for every agent
+  std::vector<QPSolutionStatus> code;
+};
+
+/**
+ * @brief Batch of independent ASI filters for multi-agent systems.
+ *
+ * Every agent has its own ASIFilter (and hence its own QP, solver, and warmstart). Agents are split into
+ * contiguous chunks that are filtered in parallel, so that backup trajectory simulation and QP solution for
+ * different agents run on different cores.
+ *
+ * Worker threads are started at construction and are signalled for every call to operator()().
+ *
+ * @note QPs are not solved with a batched (SIMD) solver. ADMM iterations of different agents diverge as soon as
+ * their active sets differ, so each QP is solved by the QPSolver of its own ASIFilter, and batching happens across
+ * threads only.
+ *
+ * @tparam G state space
+ * @tparam U input space
+ * @tparam Dyn dynamics type (must be copy-constructible)
+ * @tparam DT differentiation method
+ * @tparam M number of QP constraints (see ASIFilter)
+ */
+template<LieGroup G, Manifold U, typename Dyn, diff::Type DT = diff::Type::Default, Eigen::Index M = -1>
+class ASIFilterBatch
+{
+public:
+  /**
+   * @brief Construct a batch of ASI filters.
+   *
+   * @param n_agents number of agents
+   * @param f dynamics (see ASIFilter)
+   * @param prm filter parameters (shared by all agents)
+   * @param n_threads number of threads to distribute agents over
+   */
+  ASIFilterBatch(
+    std::size_t n_agents,
+    const Dyn & f,
+    const ASIFilterParams<U> & prm = ASIFilterParams<U>{},
+    std::size_t n_threads          = 1)
+      : n_threads_(std::clamp<std::size_t>(n_threads, 1, std::max<std::size_t>(n_agents, 1))), pool_(n_threads_)
+  {
+    filters_.reserve(n_agents);
+    for (auto i = 0u; i < n_agents; ++i) { filters_.emplace_back(f, prm); }
+    res_.u.resize(n_agents, Default<U>());
+    res_.code.resize(n_agents, QPSolutionStatus::Unknown);
+  }
+
+  /// @brief Number of agents
+  std::size_t size() const { return filters_.size(); }
+
+  /// @brief Access filter of an agent
+  ASIFilter<G, U, Dyn, DT, M> & operator[](std::size_t i) { return filters_[i]; }
+
+  /**
+   * @brief Filter inputs of all agents.
+   *
+   * @param gs current states (one per agent)
+   * @param u_des nominal (desired) control inputs (one per agent)
+   * @param h safety set definition (see ASIFilter::operator()())
+   * @param bu backup controller (see ASIFilter::operator()())
+   *
+   * @note h and bu are shared by all agents and are called concurrently if more than one thread is used.
+   *
+   * @return result in structure-of-arrays form, valid until the next call
+   */
+  const ASIFBatchResult<U> & operator()(std::span<const G> gs, std::span<const U> u_des, auto && h, auto && bu)
+  {
+    const std::size_t N = filters_.size();
+
+    assert(gs.size() == N);
+    assert(u_des.size() == N);
+
+    const std::size_t chunk = (N + n_threads_ - 1) / n_threads_;
+
+    // filter the chunk of thread th
+    const auto work = [&](std::size_t th) {
+      for (auto i = std::min(N, th * chunk); i < std::min(N, (th + 1) * chunk); ++i) {
+        std::tie(res_.u[i], res_.code[i]) = filters_[i](gs[i], u_des[i], h, bu);
+      }
+    };
+
+    pool_.run(work);
+
+    return res_;
+  }
+
+private:
+  std::size_t n_threads_;
+  ThreadPool pool_;
+  std::vector<ASIFilter<G, U, Dyn, DT, M>> filters_;
+  ASIFBatchResult<U> res_;
 };
 
 }  // namespace smooth::feedback
@@ -14,8 +14,11 @@
 #include <smooth/diff.hpp>
 
 #include <algorithm>
+#include <array>
+#include <cassert>
 #include <limits>
 #include <utility>
+#include <vector>
 
 #include "common.hpp"
 #include "qp.hpp"
@@ -52,6 +55,14 @@ struct ASIFProblem
   ManifoldBounds<U> ulim{};
 };
 
+/**
+ * @brief Integration method for the backup trajectory and its sensitivity.
+ */
+enum class ASIFIntegrator {
+  Euler,  /// @brief Explicit Euler steps for state and sensitivity
+  RK4,    /// @brief Fourth-order Runge-Kutta-Munthe-Kaas steps for the combined state-sensitivity system
+};
+
 /**
  * @brief Parameters for asif_to_qp
  */
@@ -65,19 +76,112 @@ struct ASIFtoQPParams
   double dt{0.1};
   /// relaxation cost
   double relax_cost{100};
+  /// integration method (RK4 allows for a much larger dt at the same accuracy)
+  ASIFIntegrator integrator{ASIFIntegrator::Euler};
+  /// re-use a stored backup trajectory if the initial state is closer than this to the stored initial state (0 to
+  /// disable), see ASIFBackupTrajectory
+  double backup_reuse_threshold{0};
+};
+
+/**
+ * @brief Stored backup trajectory for re-use in asif_to_qp_update().
+ *
+ * If the initial state \f$ x_0' \f$ of a new problem is close to the initial state \f$ x_0 \f$ of the stored
+ * trajectory, the backup trajectory is not re-integrated. Instead the states at the constraint instances are
+ * corrected to first order via the stored sensitivities as \f$ x_k' = x_k \oplus S_k (x_0' \ominus x_0) \f$.
+ *
+ * @note The stored trajectory is only valid as long as the dynamics and the backup controller are unchanged.
+ */
+template<LieGroup X>
+struct ASIFBackupTrajectory
+{
+  /// initial state of stored trajectory
+  X x0{Default<X>()};
+  /// states at constraint instances
+  std::vector<X> xs{};
+  /// sensitivities w.r.t. initial state at constraint instances
+  std::vector<TangentMap<X>> Ss{};
+  /// number of calls that re-used the stored trajectory since it was integrated
+  std::size_t n_reuse{0};
+  /// true if a trajectory has been stored
+  bool valid{false};
 };
 
+// \cond
+namespace detail {
+
+/**
+ * @brief Closed-loop dynamics and sensitivity derivative.
+ *
+ * Returns the closed-loop dynamics \f$ f_{cl}(t, x) = f(x, bu(t, x)) \f$ and the right-hand side
+ * \f$ (-\mathrm{ad}_{f_{cl}} + \mathrm{d}^r f_{cl}) S \f$ of the variational equation, both obtained from one
+ * differentiation of the closed-loop dynamics.
+ */
+template<LieGroup X, diff::Type DT>
+std::pair<Tangent<X>, TangentMap<X>>
+asif_cl_variational(auto && f, auto && bu, const double t, const X & x, const TangentMap<X> & S)
+{
+  auto f_cl                   = [&]<typename T>(const CastT<T, X> & vx) { return f(vx, bu(T(t), vx)); };
+  const auto [fcl, dr_fcl_dx] = diff::dr<1, DT>(std::move(f_cl), wrt(x));
+  return {fcl, (-ad<X>(fcl) + dr_fcl_dx) * S};
+}
+
+/**
+ * @brief Runge-Kutta-Munthe-Kaas step of the closed-loop dynamics and its sensitivity.
+ *
+ * Stages of the state are parameterized as \f$ x \oplus \theta \f$, and the classical RK4 tableau is applied to
+ * \f$ \dot \theta = \mathrm{d}^r \exp_\theta^{-1} f_{cl}(t, x \oplus \theta) \f$, which makes the step fourth
+ * order also on non-commutative groups (stage updates without the \f$ \mathrm{d}^r \exp^{-1} \f$ correction are
+ * only second order). The sensitivity lives in a vector space and uses the same tableau.
+ *
+ * @param[in] f dynamics
+ * @param[in] bu backup controller
+ * @param[in, out] x state
+ * @param[in, out] S sensitivity of x w.r.t. initial state
+ * @param[in] t time
+ * @param[in] h step size
+ */
+template<LieGroup X, diff::Type DT>
+void asif_rk4_step(auto && f, auto && bu, X & x, TangentMap<X> & S, const double t, const double h)
+{
+  const auto [k1x, k1S] = asif_cl_variational<X, DT>(f, bu, t, x, S);
+
+  const Tangent<X> th2   = (h / 2) * k1x;
+  const TangentMap<X> S2 = S + (h / 2) * k1S;
+  const auto [f2, k2S]   = asif_cl_variational<X, DT>(f, bu, t + h / 2, rplus(x, th2), S2);
+  const Tangent<X> k2x   = dr_expinv<X>(th2) * f2;
+
+  const Tangent<X> th3   = (h / 2) * k2x;
+  const TangentMap<X> S3 = S + (h / 2) * k2S;
+  const auto [f3, k3S]   = asif_cl_variational<X, DT>(f, bu, t + h / 2, rplus(x, th3), S3);
+  const Tangent<X> k3x   = dr_expinv<X>(th3) * f3;
+
+  const Tangent<X> th4   = h * k3x;
+  const TangentMap<X> S4 = S + h * k3S;
+  const auto [f4, k4S]   = asif_cl_variational<X, DT>(f, bu, t + h, rplus(x, th4), S4);
+  const Tangent<X> k4x   = dr_expinv<X>(th4) * f4;
+
+  x = rplus(x, Tangent<X>((h / 6) * (k1x + 2 * k2x + 2 * k3x + k4x)));
+  S += (h / 6) * (k1S + 2 * k2S + 2 * k3S + k4S);
+}
+
+}  // namespace detail
+// \endcond
+
 /**
  * @brief Allocate QP matrices (part 1 of asif_to_qp())
  *
+ * @tparam Mq number of QP constraints (-1 for dynamic, otherwise must equal K * nh + nu_ineq + 1)
+ * @tparam Nq number of QP variables (-1 for dynamic, otherwise must equal Dof<U> + 1)
+ *
  * @param[out] qp allocated QP with zero matrices
  * @param[in] K number of constraint instances
  * @param[in] nu_ineq number in inequalities in input constraint
  * @param[in] nh number of barrier constraints
  */
-template<LieGroup X, Manifold U>
-  requires(Dof<X> > 0 && Dof<U> > 0)
-void asif_to_qp_allocate(QuadraticProgram<-1, -1, double> & qp, std::size_t K, std::size_t nu_ineq, std::size_t nh)
+template<LieGroup X, Manifold U, Eigen::Index Mq, Eigen::Index Nq>
+  requires(Dof<X> > 0 && Dof<U> > 0 && (Nq == -1 || Nq == Dof<U> + 1))
+void asif_to_qp_allocate(QuadraticProgram<Mq, Nq, double> & qp, std::size_t K, std::size_t nu_ineq, std::size_t nh)
 {
   static constexpr int nx = Dof<X>;
   static constexpr int nu = Dof<U>;
@@ -88,6 +192,8 @@ void asif_to_qp_allocate(QuadraticProgram<-1, -1, double> & qp, std::size_t K, s
   const int M = K * nh + nu_ineq + 1;
   const int N = nu + 1;
 
+  assert(Mq == -1 || Mq == M);
+
   qp.A.setZero(M, N);
   qp.l.setZero(M);
   qp.u.setZero(M);
@@ -100,16 +206,19 @@ void asif_to_qp_allocate(QuadraticProgram<-1, -1, double> & qp, std::size_t K, s
  * @brief Fill QP matrices (part 2 of asif_to_qp())
  *
  * Note that the (dense) QP matrices must be pre-allocated and filled with zeros.
+ *
+ * @note Does not allocate memory if the QP sizes are static.
  */
-template<LieGroup X, Manifold U, diff::Type DT = diff::Type::Default>
+template<LieGroup X, Manifold U, diff::Type DT = diff::Type::Default, Eigen::Index Mq, Eigen::Index Nq>
   requires(Dof<X> > 0 && Dof<U> > 0)
 void asif_to_qp_update(
-  QuadraticProgram<-1, -1, double> & qp,
+  QuadraticProgram<Mq, Nq, double> & qp,
   const ASIFProblem<X, U> & pbm,
   const ASIFtoQPParams & prm,
   auto && f,
   auto && h,
-  auto && bu)
+  auto && bu,
+  ASIFBackupTrajectory<X> * backup = nullptr)
 {
   using boost::numeric::odeint::euler, boost::numeric::odeint::vector_space_algebra;
   using std::placeholders::_1;
@@ -155,8 +264,37 @@ void asif_to_qp_update(
   const auto [f0, d_f0_du] =
     diff::dr<1, DT>([&]<typename T>(const CastT<T, U> & vu) { return f(cast<T>(x), vu); }, wrt(pbm.u_des));
 
+  // check if stored backup trajectory can be re-used
+  bool reuse     = false;
+  Tangent<X> dx0 = Tangent<X>::Zero();
+  if (backup != nullptr) {
+    if (prm.backup_reuse_threshold > 0 && backup->valid && backup->xs.size() == prm.K) {
+      dx0   = rminus(pbm.x0, backup->x0);
+      reuse = dx0.norm() <= prm.backup_reuse_threshold;
+    }
+    if (reuse) {
+      ++backup->n_reuse;
+    } else {
+      backup->x0 = pbm.x0;
+      backup->xs.resize(prm.K, pbm.x0);
+      backup->Ss.resize(prm.K);
+      backup->n_reuse = 0;
+      backup->valid   = true;
+    }
+  }
+
   // loop over constraint number
   for (auto k = 0u; k != prm.K; ++k) {
+    if (reuse) {
+      // first-order correction of stored trajectory
+      t      = tau * k;
+      dx_dx0 = backup->Ss[k];
+      x      = rplus(backup->xs[k], Tangent<X>(dx_dx0 * dx0));
+    } else if (backup != nullptr) {
+      backup->xs[k] = x;
+      backup->Ss[k] = dx_dx0;
+    }
+
     // differentiate barrier function w.r.t. x
     const auto [hval, dh_dtx] =
       diff::dr<1, DT>([&h]<typename T>(const T & vt, const CastT<T, X> & vx) { return h(vt, vx); }, wrt(t, x));
@@ -171,10 +309,14 @@ void asif_to_qp_update(
     qp.u.template segment<nh>(k * nh).setConstant(std::numeric_limits<double>::infinity());
 
     // integrate system and sensitivity forward until next constraint
-    double dt_act = std::min(dt, tau * (k + 1) - t);
-    while (t < tau * (k + 1)) {
-      state_stepper.do_step(x_ode, x, t, dt_act);
-      sensi_stepper.do_step(dx_dx0_ode, dx_dx0, t, dt_act);
+    while (!reuse && t < tau * (k + 1)) {
+      const double dt_act = std::min(dt, tau * (k + 1) - t);
+      if (prm.integrator == ASIFIntegrator::RK4) {
+        detail::asif_rk4_step<X, DT>(f, bu, x, dx_dx0, t, dt_act);
+      } else {
+        state_stepper.do_step(x_ode, x, t, dt_act);
+        sensi_stepper.do_step(dx_dx0_ode, dx_dx0, t, dt_act);
+      }
       t += dt_act;
     }
   }
@@ -183,9 +325,13 @@ void asif_to_qp_update(
   qp.A.block(0, nu, prm.K * nh, 1).setConstant(1);
 
   // input bounds
+  const Tangent<U> u_des_c = rminus(pbm.u_des, pbm.ulim.c);
+
   qp.A.block(prm.K * nh, 0, nu_ineq, nu) = pbm.ulim.A;
-  qp.l.segment(prm.K * nh, nu_ineq)      = pbm.ulim.l - pbm.ulim.A * rminus(pbm.u_des, pbm.ulim.c);
-  qp.u.segment(prm.K * nh, nu_ineq)      = pbm.ulim.u - pbm.ulim.A * rminus(pbm.u_des, pbm.ulim.c);
+  qp.l.segment(prm.K * nh, nu_ineq)      = pbm.ulim.l;
+  qp.u.segment(prm.K * nh, nu_ineq)      = pbm.ulim.u;
+  qp.l.segment(prm.K * nh, nu_ineq).noalias() -= pbm.ulim.A * u_des_c;
+  qp.u.segment(prm.K * nh, nu_ineq).noalias() -= pbm.ulim.A * u_des_c;
 
   // upper and lower bounds on delta
   qp.A(prm.K * nh + nu_ineq, nu) = 1;
@@ -198,6 +344,228 @@ void asif_to_qp_update(
   qp.q(nu)     = 0;
 }
 
+/**
+ * @brief Screen barrier constraints of an ASIF QP.
+ *
+ * Barrier row \f$ i \f$ of the QP created by asif_to_qp_update() reads \f$ a_i^T \mu + \delta \geq l_i \f$ where
+ * \f$ -l_i = \dot h + \alpha h \f$ is the constraint margin at \f$ \mu = 0 \f$. Rows with margin \f$ -l_i \geq
+ * \mathrm{factor} \cdot \| a_i \| \f$ are satisfied without relaxation for all input corrections \f$ \| \mu \| \leq
+ * \mathrm{factor} \f$ and are left out of the reduced QP.
+ *
+ * The reduced QP consists of the kept barrier rows, followed by free rows (padding up to the capacity of
+ * qp_red), followed by the remaining rows of qp (input bounds and relaxation bound).
+ *
+ * @param[in] qp full QP from asif_to_qp_update()
+ * @param[out] qp_red reduced QP, must be allocated with the maximal number of kept barrier rows plus the number of
+ * non-barrier rows in qp
+ * @param[in] n_bar number of barrier rows in qp (\f$ K n_h \f$)
+ * @param[in] factor safety factor
+ * @param[out] kept indices of kept barrier rows in qp
+ *
+ * @return true if all kept rows fit in qp_red, false otherwise (qp_red is then invalid)
+ *
+ * @note Does not allocate memory if kept has sufficient capacity.
+ * @see asif_qp_screen_check() for verification of a solution of the reduced QP.
+ */
+template<Eigen::Index Mq, Eigen::Index Nq, Eigen::Index Mr>
+bool asif_qp_screen(
+  const QuadraticProgram<Mq, Nq, double> & qp,
+  QuadraticProgram<Mr, Nq, double> & qp_red,
+  const Eigen::Index n_bar,
+  const double factor,
+  std::vector<Eigen::Index> & kept)
+{
+  const Eigen::Index nu    = qp.A.cols() - 1;
+  const Eigen::Index n_oth = qp.A.rows() - n_bar;
+  const Eigen::Index n_max = qp_red.A.rows() - n_oth;
+
+  assert(n_max >= 0);
+  assert(qp_red.A.cols() == qp.A.cols());
+
+  kept.clear();
+  for (auto i = 0; i < n_bar; ++i) {
+    if (-qp.l(i) < factor * qp.A.row(i).head(nu).norm()) {
+      if (static_cast<Eigen::Index>(kept.size()) == n_max) { return false; }
+      kept.push_back(i);
+    }
+  }
+
+  const auto n_kept = static_cast<Eigen::Index>(kept.size());
+
+  for (auto j = 0; j < n_kept; ++j) {
+    qp_red.A.row(j) = qp.A.row(kept[static_cast<std::size_t>(j)]);
+    qp_red.l(j)     = qp.l(kept[static_cast<std::size_t>(j)]);
+    qp_red.u(j)     = qp.u(kept[static_cast<std::size_t>(j)]);
+  }
+
+  qp_red.A.middleRows(n_kept, n_max - n_kept).setZero();
+  qp_red.l.segment(n_kept, n_max - n_kept).setConstant(-std::numeric_limits<double>::infinity());
+  qp_red.u.segment(n_kept, n_max - n_kept).setConstant(std::numeric_limits<double>::infinity());
+
+  qp_red.A.bottomRows(n_oth) = qp.A.bottomRows(n_oth);
+  qp_red.l.tail(n_oth)       = qp.l.tail(n_oth);
+  qp_red.u.tail(n_oth)       = qp.u.tail(n_oth);
+
+  qp_red.P = qp.P;
+  qp_red.q = qp.q;
+
+  return true;
+}
+
+/**
+ * @brief Check that a solution satisfies all barrier constraints of an ASIF QP.
+ *
+ * @param qp full QP from asif_to_qp_update()
+ * @param n_bar number of barrier rows in qp (\f$ K n_h \f$)
+ * @param x QP primal solution \f$ (\mu, \delta) \f$
+ * @param tol constraint tolerance
+ *
+ * @return true if all barrier rows are satisfied within tol
+ */
+template<Eigen::Index Mq, Eigen::Index Nq>
+bool asif_qp_screen_check(
+  const QuadraticProgram<Mq, Nq, double> & qp, const Eigen::Index n_bar, const auto & x, const double tol)
+{
+  for (auto i = 0; i < n_bar; ++i) {
+    if (qp.A.row(i).dot(x) < qp.l(i) - tol) { return false; }
+  }
+  return true;
+}
+
+/**
+ * @brief Solve an ASIF QP in closed form if at most one barrier constraint is active.
+ *
+ * For the QP created by asif_to_qp_update() with diagonal input weights and box input bounds (i.e. ManifoldBounds
+ * with a diagonal matrix, or no input bounds) the solution is found without iterations as follows:
+ *  - If all barrier constraints are satisfied for \f$ \mu = 0 \f$ that is the solution.
+ *  - Otherwise, for the most violated barrier constraint \f$ a_i^T \mu + \delta \geq l_i \f$ the problem with only
+ * that constraint is solved exactly: the solution is \f$ \mu = \mathrm{clip}(\lambda W^{-1} a_i) \f$, \f$ \delta =
+ * \lambda / \rho \f$ where the multiplier \f$ \lambda \f$ is the root of a piecewise linear increasing function. If
+ * the candidate satisfies all other barrier constraints it solves the full QP.
+ *
+ * The cost is linear in the number of barrier constraints.
+ *
+ * @param[in] qp QP from asif_to_qp_update()
+ * @param[in] n_bar number of barrier rows in qp (\f$ K n_h \f$)
+ * @param[out] sol solution (primal and dual) if successful, must be pre-allocated
+ * @param[in] tol tolerance when checking the remaining barrier constraints
+ *
+ * @return true if the QP was solved, false if it has a different structure or the candidate violates another
+ * barrier constraint
+ *
+ * @note Does not allocate memory.
+ */
+template<Eigen::Index Mq, Eigen::Index Nq>
+  requires(Nq > 1)
+bool asif_qp_closed_form(
+  const QuadraticProgram<Mq, Nq, double> & qp,
+  const Eigen::Index n_bar,
+  QPSolution<Mq, Nq, double> & sol,
+  const double tol = 1e-9)
+{
+  static constexpr Eigen::Index nu = Nq - 1;
+  static constexpr double inf      = std::numeric_limits<double>::infinity();
+
+  const Eigen::Index n_ineq = qp.A.rows() - n_bar - 1;
+
+  assert(sol.primal.size() == Nq);
+  assert(sol.dual.size() == qp.A.rows());
+
+  // cost must be diagonal
+  const Eigen::Vector<double, nu> w = qp.P.diagonal().template head<nu>();
+  const double rho                  = qp.P(nu, nu);
+  if (!(w.minCoeff() > 0) || !(rho > 0) || !qp.q.isZero()) { return false; }
+
+  // input bounds must be a box that contains zero
+  Eigen::Vector<double, nu> lo = Eigen::Vector<double, nu>::Constant(-inf);
+  Eigen::Vector<double, nu> hi = Eigen::Vector<double, nu>::Constant(inf);
+  if (n_ineq == nu) {
+    const auto Au = qp.A.template block<nu, nu>(n_bar, 0);
+    for (auto i = 0; i < nu; ++i) {
+      for (auto j = 0; j < nu; ++j) {
+        if (i != j && Au(i, j) != 0) { return false; }
+      }
+      const double a = Au(i, i);
+      if (a == 0) { return false; }
+      lo(i) = (a > 0 ? qp.l(n_bar + i) : qp.u(n_bar + i)) / a;
+      hi(i) = (a > 0 ? qp.u(n_bar + i) : qp.l(n_bar + i)) / a;
+    }
+  } else if (n_ineq != 0) {
+    return false;
+  }
+  if (!(lo.maxCoeff() <= 0 && hi.minCoeff() >= 0)) { return false; }
+
+  sol.code      = QPSolutionStatus::Optimal;
+  sol.iter      = 0;
+  sol.objective = 0;
+  sol.primal.setZero();
+  sol.dual.setZero();
+
+  // zero input correction
+  if (n_bar == 0) { return true; }
+
+  Eigen::Index i;
+  const double li = qp.l.head(n_bar).maxCoeff(&i);
+  if (li <= 0) { return true; }
+
+  // single active barrier constraint: the most violated one
+  // mu(lambda) = clip(lambda * v)
+  const Eigen::Vector<double, nu> a = qp.A.row(i).template head<nu>();
+  const Eigen::Vector<double, nu> v = a.cwiseQuotient(w);
+
+  const auto mu_fun = [&](double lam) -> Eigen::Vector<double, nu> { return (lam * v).cwiseMax(lo).cwiseMin(hi); };
+  const auto g_fun  = [&](double lam) { return a.dot(mu_fun(lam)) + lam / rho; };
+
+  // values of lambda where an input saturates
+  std::array<double, nu> bps;
+  std::size_t n_bps = 0;
+  for (auto j = 0; j < nu; ++j) {
+    if (v(j) > 0 && hi(j) < inf) {
+      bps[n_bps++] = hi(j) / v(j);
+    } else if (v(j) < 0 && lo(j) > -inf) {
+      bps[n_bps++] = lo(j) / v(j);
+    }
+  }
+  std::sort(bps.begin(), bps.begin() + static_cast<std::ptrdiff_t>(n_bps));
+
+  // find root of g(lambda) = li, g is piecewise linear between breakpoints
+  double lam_a = 0, g_a = 0, lam = -1;
+  for (auto k = 0u; k < n_bps; ++k) {
+    const double g_b = g_fun(bps[k]);
+    if (g_b >= li) {
+      lam = lam_a + (li - g_a) * (bps[k] - lam_a) / (g_b - g_a);
+      break;
+    }
+    lam_a = bps[k];
+    g_a   = g_b;
+  }
+  if (lam < 0) { lam = lam_a + (li - g_a) / (g_fun(lam_a + 1) - g_a); }
+
+  const Eigen::Vector<double, nu> mu = mu_fun(lam);
+  const double delta                 = lam / rho;
+
+  // verify remaining barrier constraints
+  bool feasible = true;
+  for (auto k = 0; k < n_bar && feasible; ++k) {
+    feasible = qp.A.row(k).template head<nu>().dot(mu) + delta >= qp.l(k) - tol;
+  }
+  if (!feasible) { return false; }
+
+  sol.primal.template head<nu>() = mu;
+  sol.primal(nu)                 = delta;
+  sol.objective                  = 0.5 * (mu.dot(w.cwiseProduct(mu)) + rho * delta * delta);
+
+  // multipliers from stationarity
+  sol.dual(i) = -lam;
+  if (n_ineq == nu) {
+    for (auto j = 0; j < nu; ++j) {
+      if (mu(j) != lam * v(j)) { sol.dual(n_bar + j) = (lam * a(j) - w(j) * mu(j)) / qp.A(n_bar + j, j); }
+    }
+  }
+
+  return true;
+}
+
 /**
  * @brief Convert an ASIFProblem to a QuadraticProgram.
  *
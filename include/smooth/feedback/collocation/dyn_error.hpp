@@ -7,12 +7,71 @@
  * @brief Collocation dynamics constraints.
  */
 
+#include <algorithm>
+#include <type_traits>
+
 #include <Eigen/Core>
 
 #include "mesh.hpp"
+#include "smooth/feedback/utils/thread_pool.hpp"
 
 namespace smooth::feedback {
 
+// \cond
+namespace detail {
+
+/**
+ * @brief Calculate relative dynamics error in interval ival of mesh.
+ *
+ * @see mesh_dyn_error()
+ */
+template<int Nx>
+double mesh_ival_dyn_error(
+  auto && f,
+  const MeshType auto & m,
+  const std::size_t ival,
+  const double t0,
+  const double tf,
+  auto && xfun,
+  auto && ufun)
+{
+  using smooth::utils::zip;
+
+  const auto Kext = m.N_colloc_ival(ival);
+
+  // evaluate xs and F at those points
+  Eigen::Matrix<double, Nx, -1> Fval(Nx, Kext + 1);
+  Eigen::Matrix<double, Nx, -1> Xval(Nx, Kext + 1);
+  for (const auto & [j, tau] : zip(std::views::iota(0u, Kext + 1), m.interval_nodes(ival))) {
+    const double tj = t0 + (tf - t0) * tau;
+
+    // evaluate x and u values at tj using current degree polynomials
+    const auto Xj = xfun(tj);
+    const auto Uj = ufun(tj);
+
+    // evaluate right-hand side of dynamics at tj
+    Fval.col(j) = f(tj, Xj, Uj);
+
+    // store x values for later comparison
+    Xval.col(j) = Xj;
+  }
+
+  // "integrate" system inside interval
+  const auto [alpha, Ius] = m.interval_intmat_unscaled(ival);
+  const Eigen::MatrixXd Xval_est =
+    Xval.col(0).replicate(1, Kext) + ((tf - t0) * alpha) * (Fval.leftCols(Kext) * Ius);
+
+  // absolute error in interval
+  Eigen::VectorXd e_abs = (Xval_est - Xval.rightCols(Kext)).colwise().norm();
+  Eigen::VectorXd e_rel = e_abs / (1. + Xval.rightCols(Kext).colwise().norm().maxCoeff());
+
+  // mex relative error on interval
+  return e_rel.maxCoeff();
+}
+
+}  // namespace detail
+// \endcond
+
 /**
  * @brief Calculate relative dynamics errors for each interval in mesh.
  *
@@ -22,13 +81,22 @@ namespace smooth::feedback {
  * @param tf final time variable
  * @param xfun state trajectory
  * @param ufun input trajectory
+ * @param pool threads to distribute intervals over (evaluation is serial if nullptr)
  *
  * @return vector with relative errors for every interval in m
+ *
+ * @note Trajectories such as OCPSolution::x carry evaluation state, so when pool is used every thread works on its
+ * own copies of f, xfun, and ufun (threading is disabled if they are not copy-constructible).
  */
-Eigen::VectorXd
-mesh_dyn_error(auto && f, const MeshType auto & m, const double t0, const double tf, auto && xfun, auto && ufun)
+Eigen::VectorXd mesh_dyn_error(
+  auto && f,
+  const MeshType auto & m,
+  const double t0,
+  const double tf,
+  auto && xfun,
+  auto && ufun,
+  ThreadPool * pool = nullptr)
 {
-  using smooth::utils::zip;
   static constexpr auto Nx = std::invoke_result_t<decltype(xfun), double>::SizeAtCompileTime;
 
   static_assert(Nx > 0, "Static size required");
@@ -37,39 +105,41 @@ mesh_dyn_error(auto && f, const MeshType auto & m, const double t0, const double
 
   Eigen::VectorXd ival_errs(N);
 
-  // for each interval
-  for (auto ival = 0u, M = 0u; ival < N; M += m.N_colloc_ival(ival), ++ival) {
-    const auto Kext = m.N_colloc_ival(ival);
-
-    // evaluate xs and F at those points
-    Eigen::Matrix<double, Nx, -1> Fval(Nx, Kext + 1);
-    Eigen::Matrix<double, Nx, -1> Xval(Nx, Kext + 1);
-    for (const auto & [j, tau] : zip(std::views::iota(0u, Kext + 1), m.interval_nodes(ival))) {
-      const double tj = t0 + (tf - t0) * tau;
-
-      // evaluate x and u values at tj using current degree polynomials
-      const auto Xj = xfun(tj);
-      const auto Uj = ufun(tj);
-
-      // evaluate right-hand side of dynamics at tj
-      Fval.col(j) = f(tj, Xj, Uj);
-
-      // store x values for later comparison
-      Xval.col(j) = Xj;
+  const auto work = [&](std::size_t i0, std::size_t i1, auto && f_w, auto && xfun_w, auto && ufun_w) {
+    for (auto ival = i0; ival < i1; ++ival) {
+      ival_errs(static_cast<Eigen::Index>(ival)) =
+        detail::mesh_ival_dyn_error<Nx>(f_w, m, ival, t0, tf, xfun_w, ufun_w);
+    }
+  };
+
+  using F_t  = std::decay_t<decltype(f)>;
+  using XF_t = std::decay_t<decltype(xfun)>;
+  using UF_t = std::decay_t<decltype(ufun)>;
+
+  if constexpr (
+    std::is_copy_constructible_v<F_t> && std::is_copy_constructible_v<XF_t> && std::is_copy_constructible_v<UF_t>) {
+    const std::size_t n_threads = std::min<std::size_t>(pool ? pool->size() : 1, N);
+    if (n_threads > 1) {
+      const std::size_t chunk = (N + n_threads - 1) / n_threads;
+
+      // originals are only read while threads copy them
+      pool->run([&](std::size_t th) {
+        const auto i0 = std::min(N, th * chunk);
+        const auto i1 = std::min(N, (th + 1) * chunk);
+        if (i0 < i1) {
+          F_t f_c(f);
+          XF_t xfun_c(xfun);
+          UF_t ufun_c(ufun);
+          work(i0, i1, f_c, xfun_c, ufun_c);
+        }
+      });
+
+      return ival_errs;
     }
-
-    // "integrate" system inside interval
-    const Eigen::MatrixXd Xval_est =
-      Xval.col(0).replicate(1, Kext) + (tf - t0) * Fval.leftCols(Kext) * m.interval_intmat(ival);
-
-    // absolute error in interval
-    Eigen::VectorXd e_abs = (Xval_est - Xval.rightCols(Kext)).colwise().norm();
-    Eigen::VectorXd e_rel = e_abs / (1. + Xval.rightCols(Kext).colwise().norm().maxCoeff());
-
-    // mex relative error on interval
-    ival_errs(ival) = e_rel.maxCoeff();
   }
 
+  work(0, N, f, xfun, ufun);
+
   return ival_errs;
 }
 
@@ -7,12 +7,14 @@
  * @brief Refinable Legendre-Gauss-Radau mesh of time interval [0, 1]
  */
 
+#include <algorithm>
+#include <array>
 #include <ranges>
 #include <span>
+#include <utility>
 #include <vector>
 
 #include <Eigen/Core>
-#include <Eigen/LU>
 #include <smooth/detail/traits.hpp>
 #include <smooth/detail/utils.hpp>
 #include <smooth/polynomial/quadrature.hpp>
@@ -47,6 +49,129 @@ constexpr std::pair<std::array<double, K + 1>, std::array<double, K + 1>> lgr_pl
   return {ns, ws};
 }
 
+/**
+ * @brief All nodes and weights of a mesh with NIvals equally sized intervals with K LGR nodes each.
+ *
+ * @note Includes extra point at 1 (with zero weight).
+ */
+template<std::size_t K, std::size_t NIvals>
+constexpr std::pair<std::array<double, K * NIvals + 1>, std::array<double, K * NIvals + 1>> fixed_mesh_nodes()
+{
+  const auto nw = lgr_plus_one<K>();
+
+  std::array<double, K * NIvals + 1> ns, ws;
+  for (auto i = 0u; i < NIvals; ++i) {
+    for (auto j = 0u; j < K; ++j) {
+      ns[i * K + j] = (static_cast<double>(i) + (nw.first[j] + 1) / 2) / static_cast<double>(NIvals);
+      ws[i * K + j] = nw.second[j] / static_cast<double>(2 * NIvals);
+    }
+  }
+  ns[K * NIvals] = 1;
+  ws[K * NIvals] = 0;
+  return {ns, ws};
+}
+
+/**
+ * @brief Differentiation matrix of the Lagrange polynomials through K+1 nodes.
+ *
+ * Returns a row-major (K+1 x K) matrix D s.t. D[j][k] is the derivative of the j:th Lagrange polynomial
+ * evaluated at node k. Derivatives are computed from barycentric weights.
+ */
+template<std::size_t K>
+constexpr std::array<std::array<double, K>, K + 1> lagrange_diffmat(const std::array<double, K + 1> & ns)
+{
+  // barycentric weights
+  std::array<double, K + 1> w{};
+  for (auto j = 0u; j <= K; ++j) {
+    w[j] = 1;
+    for (auto m = 0u; m <= K; ++m) {
+      if (m != j) { w[j] /= ns[j] - ns[m]; }
+    }
+  }
+
+  std::array<std::array<double, K>, K + 1> D{};
+  for (auto k = 0u; k < K; ++k) {
+    for (auto j = 0u; j <= K; ++j) {
+      if (j != k) {
+        D[j][k] = (w[j] / w[k]) / (ns[k] - ns[j]);
+        D[k][k] -= D[j][k];
+      }
+    }
+  }
+  return D;
+}
+
+/**
+ * @brief Integration matrix corresponding to a differentiation matrix.
+ *
+ * Returns the inverse of the lower (K x K) block of D.
+ */
+template<std::size_t K>
+constexpr std::array<std::array<double, K>, K> lagrange_intmat(const std::array<std::array<double, K>, K + 1> & D)
+{
+  // Gauss-Jordan elimination on [A | I] where A is the lower K x K block of D
+  std::array<std::array<double, K>, K> A{}, I{};
+  for (auto i = 0u; i < K; ++i) {
+    A[i]    = D[i + 1];
+    I[i][i] = 1;
+  }
+
+  const auto abs = [](double x) { return x < 0 ? -x : x; };
+
+  for (auto c = 0u; c < K; ++c) {
+    // partial pivoting
+    auto p = c;
+    for (auto r = c + 1; r < K; ++r) {
+      if (abs(A[r][c]) > abs(A[p][c])) { p = r; }
+    }
+    std::swap(A[c], A[p]);
+    std::swap(I[c], I[p]);
+
+    const double piv = A[c][c];
+    for (auto j = 0u; j < K; ++j) {
+      A[c][j] /= piv;
+      I[c][j] /= piv;
+    }
+
+    for (auto r = 0u; r < K; ++r) {
+      if (r != c && A[r][c] != 0) {
+        const double fac = A[r][c];
+        for (auto j = 0u; j < K; ++j) {
+          A[r][j] -= fac * A[c][j];
+          I[r][j] -= fac * I[c][j];
+        }
+      }
+    }
+  }
+  return I;
+}
+
+/// @brief Unscaled (w.r.t. [-1, 1]) differentiation matrix for K LGR nodes plus one extra node at +1.
+template<std::size_t K>
+inline constexpr auto lgr_diffmat_v = lagrange_diffmat<K>(lgr_plus_one<K>().first);
+
+/// @brief Unscaled (w.r.t. [-1, 1]) integration matrix for K LGR nodes plus one extra node at +1.
+template<std::size_t K>
+inline constexpr auto lgr_intmat_v = lagrange_intmat<K>(lgr_diffmat_v<K>);
+
+/// @brief Pointers to lgr_diffmat_v data for K in [Kmin, Kmax]
+template<std::size_t Kmin, std::size_t Kmax>
+constexpr std::array<const double *, Kmax + 1 - Kmin> lgr_diffmat_table()
+{
+  return []<std::size_t... Is>(std::index_sequence<Is...>) {
+    return std::array<const double *, sizeof...(Is)>{lgr_diffmat_v<Kmin + Is>[0].data()...};
+  }(std::make_index_sequence<Kmax + 1 - Kmin>{});
+}
+
+/// @brief Pointers to lgr_intmat_v data for K in [Kmin, Kmax]
+template<std::size_t Kmin, std::size_t Kmax>
+constexpr std::array<const double *, Kmax + 1 - Kmin> lgr_intmat_table()
+{
+  return []<std::size_t... Is>(std::index_sequence<Is...>) {
+    return std::array<const double *, sizeof...(Is)>{lgr_intmat_v<Kmin + Is>[0].data()...};
+  }(std::make_index_sequence<Kmax + 1 - Kmin>{});
+}
+
 }  // namespace detail
 
 /**
@@ -80,7 +205,7 @@ public:
    *
    * @note Allocates heap memory.
    */
-  inline Mesh() : intervals_(1, Interval{.K = Kmin, .tau0 = 0.}) {}
+  inline Mesh() : intervals_(1, Interval{.K = Kmin, .tau0 = 0.}) { update_prefix(); }
 
   /**
    * @brief Create a mesh consisting of a n intervals of equal size over [0, 1].
@@ -101,6 +226,7 @@ public:
       intervals_.reserve(n);
       for (std::size_t i = 0; i < n; ++i) { intervals_.emplace_back(k, static_cast<double>(i) * dx); }
     }
+    update_prefix();
   }
 
   /**
@@ -111,10 +237,17 @@ public:
   /**
    * @brief Number of collocation points in mesh.
    */
-  inline std::size_t N_colloc() const
+  inline std::size_t N_colloc() const { return prefix_.back(); }
+
+  /**
+   * @brief Number of collocation points in intervals before interval i.
+   *
+   * @note This is the index of the first collocation point in interval i.
+   */
+  inline std::size_t N_colloc_before(std::size_t i) const
   {
-    return std::accumulate(
-      intervals_.begin(), intervals_.end(), 0u, [](std::size_t curr, const auto & x) { return curr + x.K; });
+    assert(i <= intervals_.size());
+    return prefix_[i];
   }
 
   /**
@@ -164,6 +297,7 @@ public:
       // refine by increasing degree in interval
       intervals_[i].K = D;
     }
+    update_prefix();
   }
 
   /**
@@ -198,6 +332,7 @@ public:
     assert(Kmin <= K);
     assert(K <= Kmax + 1);
     intervals_[i].K = K;
+    update_prefix();
   }
 
   /**
@@ -329,7 +464,7 @@ public:
    * \f],
    * where \f$ y(\cdot) \in \mathbb{R}^{d \times 1} \f$ is a Lagrange polynomial in interval i.
    *
-   * @note Allocates heap memory for return value.
+   * @note Allocates memory for the return value, see interval_diffmat_unscaled() for an allocation-free version.
    */
   inline Eigen::MatrixXd interval_diffmat(std::size_t i) const
   {
@@ -338,21 +473,7 @@ public:
     const double tau0 = intervals_[i].tau0;
     const double tauf = i + 1 < intervals_.size() ? intervals_[i + 1].tau0 : 1.;
 
-    Eigen::MatrixXd ret(k + 1, k);
-
-    utils::static_for<Kmax + 2 - Kmin>([&](auto ivar) {
-      static constexpr auto K = Kmin + ivar;
-      if (K == k) {
-        static constexpr auto nw_ext_s = detail::lgr_plus_one<K>();
-        static constexpr auto B_ext_s  = lagrange_basis<K>(nw_ext_s.first);
-        static constexpr auto D_ext_s =
-          polynomial_basis_derivatives<K, K + 1>(B_ext_s, nw_ext_s.first).template block<K + 1, K>(0, 0);
-        ret = MatMap(D_ext_s[0].data(), k + 1, k);
-      }
-    });
-
-    ret *= 2. / (tauf - tau0);
-    return ret;
+    return (2. / (tauf - tau0)) * MatMap(kDiffTbl[k - Kmin], k + 1, k);
   }
 
   /**
@@ -366,26 +487,54 @@ public:
   {
     const std::size_t k = intervals_[i].K;
 
+    assert(Kmin <= k && k <= Kmax + 1);
+
     const double tau0 = intervals_[i].tau0;
     const double tauf = i + 1 < intervals_.size() ? intervals_[i + 1].tau0 : 1.;
 
+    return {2. / (tauf - tau0), MatMap(kDiffTbl[k - Kmin], k + 1, k)};
+  }
+
+  /**
+   * @brief Interval Lagrange basis w.r.t. the normalized interval timescale u in [-1, 1].
+   *
+   * Returns a (row-major) matrix \f$ B \f$ s.t. the monomial coefficients of the polynomial through
+   * the interval values are
+   * \f[
+   *   \begin{bmatrix} c_0 & c_1 & \cdots & c_K \end{bmatrix}
+   *  =
+   *   \begin{bmatrix} y(\tau_{i, 0}) & y(\tau_{i, 1}) & \cdots & y(\tau_{i, K}) \end{bmatrix} B^T,
+   * \f]
+   * i.e. \f$ y(u) = \sum_j c_j u^j \f$ where \f$ u = 2 (\tau - \tau_{i, 0}) / (\tau_{i+1, 0} - \tau_{i, 0}) - 1 \f$.
+   *
+   * @param i interval index
+   * @param extend set to true if a value is provided for t=+1 (only affects last interval)
+   *
+   * @note The returned size is (K+1 x K+1), or (K x K) in the last interval if extend is false.
+   */
+  inline MatMap interval_basis(std::size_t i, bool extend = true) const
+  {
+    const std::size_t k = intervals_[i].K;
+
     MatMap ret(nullptr, 0, 0);
 
     utils::static_for<Kmax + 2 - Kmin>([&](auto ivar) {
       static constexpr auto K = Kmin + ivar;
       if (K == k) {
-        static constexpr auto nw_ext_s = detail::lgr_plus_one<K>();
-        static constexpr auto B_ext_s  = lagrange_basis<K>(nw_ext_s.first);
-        // BR: Constrexpr was removed since it isn't a constexpr expression
-        // static constexpr auto D_ext_s =
-        static const auto D_ext_s =
-          polynomial_basis_derivatives<K, K + 1>(B_ext_s, nw_ext_s.first).template block<K + 1, K>(0, 0);
-        // Eigen maps don't have copy constructors so use placement new
-        new (&ret) MatMap(D_ext_s[0].data(), k + 1, k);
+        if (extend || i + 1 < intervals_.size()) {
+          static constexpr auto nw_ext_s = detail::lgr_plus_one<K>();
+          static constexpr auto B_ext_s  = lagrange_basis<K>(nw_ext_s.first);
+          // Eigen maps don't have copy constructors so use placement new
+          new (&ret) MatMap(B_ext_s[0].data(), k + 1, k + 1);
+        } else {
+          static constexpr auto nw_s = lgr_nodes<K>();
+          static constexpr auto B_s  = lagrange_basis<K - 1>(nw_s.first);
+          new (&ret) MatMap(B_s[0].data(), k, k);
+        }
       }
     });
 
-    return {2. / (tauf - tau0), ret};
+    return ret;
   }
 
   /**
@@ -404,14 +553,44 @@ public:
    * where \f$ y(\cdot) \in \mathbb{R}^{d \times 1} \f$ is a Lagrange
    * polynomial in interval i.
    *
-   * @note Allocates heap memory for return value.
-   *
-   * @note Performs a matrix inverse.
+   * @note Allocates memory for the return value, see interval_intmat_unscaled() for an allocation-free version.
    */
   inline Eigen::MatrixXd interval_intmat(std::size_t i) const
   {
     const std::size_t k = intervals_[i].K;
-    return interval_diffmat(i).block(1, 0, k, k).inverse();
+
+    const double tau0 = intervals_[i].tau0;
+    const double tauf = i + 1 < intervals_.size() ? intervals_[i + 1].tau0 : 1.;
+
+    return ((tauf - tau0) / 2) * MatMap(kIntTbl[k - Kmin], k, k);
+  }
+
+  /**
+   * @brief Interval integration matrix (unscaled).
+   *
+   * Returns a Map I_us and a scalar alpha s.t. I = alpha * I_us
+   *
+   * @see interval_intmat
+   */
+  inline std::pair<double, MatMap> interval_intmat_unscaled(std::size_t i) const
+  {
+    const std::size_t k = intervals_[i].K;
+
+    assert(Kmin <= k && k <= Kmax + 1);
+
+    const double tau0 = intervals_[i].tau0;
+    const double tauf = i + 1 < intervals_.size() ? intervals_[i + 1].tau0 : 1.;
+
+    return {(tauf - tau0) / 2, MatMap(kIntTbl[k - Kmin], k, k)};
+  }
+
+  /**
+   * @brief Start of interval i on [0, 1] timescale.
+   */
+  inline double interval_start(std::size_t i) const
+  {
+    assert(i < intervals_.size());
+    return intervals_[i].tau0;
   }
 
   /**
@@ -433,6 +612,7 @@ public:
   void increase_degrees()
   {
     for (auto & ival : intervals_) { ival.K = std::min(ival.K + 1, Kmax + 1); }
+    update_prefix();
   }
 
   /**
@@ -441,6 +621,7 @@ public:
   void decrease_degrees()
   {
     for (auto & ival : intervals_) { ival.K = std::max(ival.K - 1, Kmin); }
+    update_prefix();
   }
 
   /**
@@ -464,8 +645,7 @@ public:
 
     const double u = 2 * (t - tau0) / (tauf - tau0) - 1;
 
-    int64_t N_before = 0;
-    for (auto i = 0u; i < ival; ++i) { N_before += intervals_[i].K; }
+    const auto N_before = static_cast<int64_t>(prefix_[ival]);
 
     // initialize output variable
     RetT ret = RetT::Zero(std::ranges::begin(r)->size());
@@ -494,6 +674,86 @@ public:
     return ret;
   }
 
+  /**
+   * @brief Evaluate a function at many sorted time points.
+   *
+   * Equivalent to calling eval() for each time point, but intervals are traversed once and the
+   * interval values are gathered once per interval.
+   *
+   * @param ts time values in [0, 1], sorted in increasing order
+   * @param r values for the collocation points (size N [extend=false] or N+1 [extend=true])
+   * @param p derivative to evaluate
+   * @param extend set to true if a value is provided for t=+1
+   *
+   * @return matrix with function values as columns, size dim x size(ts)
+   *
+   * @note Allocates heap memory for return value.
+   */
+  Eigen::MatrixXd
+  eval_many(std::ranges::sized_range auto && ts, std::ranges::range auto && r, std::size_t p = 0, bool extend = true)
+    const
+  {
+    const auto dim      = static_cast<Eigen::Index>(std::ranges::begin(r)->size());
+    const std::size_t N = intervals_.size();
+    const auto n_ts     = static_cast<std::size_t>(std::ranges::size(ts));
+
+    Eigen::MatrixXd ret(dim, static_cast<Eigen::Index>(n_ts));
+    Eigen::MatrixXd V;  // values in current interval
+
+    auto t_it     = std::ranges::begin(ts);
+    std::size_t j = 0;  // index of current time point
+
+    for (std::size_t ival = 0; ival < N && j < n_ts; ++ival) {
+      const bool last   = ival + 1 == N;
+      const double tau0 = intervals_[ival].tau0;
+      const double tauf = last ? 1. : intervals_[ival + 1].tau0;
+
+      // times before the first interval belong to the first, and times after the last to the last
+      auto t_it1     = t_it;
+      std::size_t j1 = j;
+      while (j1 < n_ts && (last || static_cast<double>(*t_it1) < tauf)) {
+        ++t_it1;
+        ++j1;
+      }
+      if (j1 == j) { continue; }
+
+      const std::size_t k  = intervals_[ival].K;
+      const bool ext       = extend || !last;
+      const std::size_t nv = ext ? k + 1 : k;
+
+      V.resize(dim, static_cast<Eigen::Index>(nv));
+      for (const auto & [c, v] : zip(iota(0u, nv), r | drop(static_cast<int64_t>(prefix_[ival])))) {
+        V.col(static_cast<Eigen::Index>(c)) = v;
+      }
+
+      utils::static_for<Kmax + 2 - Kmin>([&](auto i) {
+        static constexpr auto K = Kmin + i;
+        if (K == k) {
+          for (; j < j1; ++j, ++t_it) {
+            const double u = 2 * (static_cast<double>(*t_it) - tau0) / (tauf - tau0) - 1;
+            if (ext) {
+              static constexpr auto nw_ext_s = detail::lgr_plus_one<K>();
+              static constexpr auto B_ext_s  = lagrange_basis<K>(nw_ext_s.first);  // K+1 x K+1
+              const auto W                   = monomial_derivative<K>(u, p) * B_ext_s;
+
+              ret.col(static_cast<Eigen::Index>(j)).noalias() =
+                V * Eigen::Map<const Eigen::VectorXd>(W[0].data(), static_cast<Eigen::Index>(K + 1));
+            } else {
+              static constexpr auto nw_s = lgr_nodes<K>();
+              static constexpr auto B_s  = lagrange_basis<K - 1>(nw_s.first);  // K x K
+              const auto W               = monomial_derivative<K - 1>(u, p) * B_s;
+
+              ret.col(static_cast<Eigen::Index>(j)).noalias() =
+                V * Eigen::Map<const Eigen::VectorXd>(W[0].data(), static_cast<Eigen::Index>(K));
+            }
+          }
+        }
+      });
+    }
+
+    return ret;
+  }
+
 private:
   struct Interval
   {
@@ -503,12 +763,284 @@ private:
     double tau0;
   };
 
+  /// @brief Unscaled differentiation matrices for K in [Kmin, Kmax + 1]
+  static constexpr auto kDiffTbl = detail::lgr_diffmat_table<Kmin, Kmax + 1>();
+
+  /// @brief Unscaled integration matrices for K in [Kmin, Kmax + 1]
+  static constexpr auto kIntTbl = detail::lgr_intmat_table<Kmin, Kmax + 1>();
+
+  /// @brief Re-compute prefix_ (must be called whenever intervals_ is modified)
+  inline void update_prefix()
+  {
+    prefix_.resize(intervals_.size() + 1);
+    prefix_[0] = 0;
+    for (auto i = 0u; i < intervals_.size(); ++i) { prefix_[i + 1] = prefix_[i] + intervals_[i].K; }
+  }
+
   /// @brief Mesh intervals
   std::vector<Interval> intervals_;
+
+  /// @brief Number of collocation points before each interval (and total number at the end)
+  std::vector<std::size_t> prefix_;
+};
+
+/**
+ * @brief Collocation mesh of interval [0, 1] with a fixed number of equally sized intervals.
+ * @tparam _K number of collocation points per interval
+ * @tparam _NIvals number of intervals
+ *
+ * Offers the same interface as Mesh except for refinement. Nodes, weights and interval matrices are
+ * compile-time constants and all loops have compile-time trip counts.
+ */
+template<std::size_t _K, std::size_t _NIvals>
+  requires(_K >= 1 && _NIvals >= 1)
+class FixedMesh
+{
+  using DMap = Eigen::Map<const Eigen::Matrix<double, _K + 1, _K, Eigen::RowMajor>>;
+  using IMap = Eigen::Map<const Eigen::Matrix<double, _K, _K, Eigen::RowMajor>>;
+
+  // nodes and weights on [-1, 1] including extra node at +1
+  static constexpr auto kNwExt = detail::lgr_plus_one<_K>();
+  // nodes and weights on [-1, 1]
+  static constexpr auto kNw = lgr_nodes<_K>();
+  // Lagrange basis for interval with extra node at +1
+  static constexpr auto kBExt = lagrange_basis<_K>(kNwExt.first);
+  // Lagrange basis for interval without extra node at +1
+  static constexpr auto kB = lagrange_basis<_K - 1>(kNw.first);
+  // all nodes and weights on [0, 1]
+  static constexpr auto kAllNw = detail::fixed_mesh_nodes<_K, _NIvals>();
+
+  // unscaled differentiation matrix
+  static constexpr const auto & kD = detail::lgr_diffmat_v<_K>;
+  // unscaled integration matrix
+  static constexpr const auto & kI = detail::lgr_intmat_v<_K>;
+
+public:
+  /// @brief Minimal number of collocation points per interval
+  static constexpr auto Kmin = _K;
+  /// @brief Maximal number of collocation points per interval
+  static constexpr auto Kmax = _K;
+  /// @brief Number of intervals
+  static constexpr auto NIvals = _NIvals;
+
+  /**
+   * @brief Number of intervals in mesh.
+   */
+  static constexpr std::size_t N_ivals() { return _NIvals; }
+
+  /**
+   * @brief Number of collocation points in mesh.
+   */
+  static constexpr std::size_t N_colloc() { return _K * _NIvals; }
+
+  /**
+   * @brief Number of collocation points in interval i.
+   */
+  static constexpr std::size_t N_colloc_ival([[maybe_unused]] std::size_t i)
+  {
+    assert(i < _NIvals);
+    return _K;
+  }
+
+  /**
+   * @brief Number of collocation points in intervals before interval i.
+   */
+  static constexpr std::size_t N_colloc_before(std::size_t i)
+  {
+    assert(i <= _NIvals);
+    return _K * i;
+  }
+
+  /**
+   * @brief Start of interval i on [0, 1] timescale.
+   */
+  static constexpr double interval_start(std::size_t i)
+  {
+    assert(i < _NIvals);
+    return static_cast<double>(i) / static_cast<double>(_NIvals);
+  }
+
+  /**
+   * @brief Interval nodes (as range of doubles).
+   *
+   * @see Mesh::interval_nodes()
+   */
+  inline auto interval_nodes(std::size_t i) const
+  {
+    const double tau0 = interval_start(i);
+    const double al   = 1. / static_cast<double>(2 * _NIvals);
+
+    return transform(
+      std::span<const double, _K + 1>(kNwExt.first), [tau0, al](double d) -> double { return tau0 + al * (d + 1); });
+  }
+
+  /**
+   * @brief Nodes (as range of doubles).
+   *
+   * @see Mesh::all_nodes()
+   */
+  inline auto all_nodes() const { return std::views::all(kAllNw.first); }
+
+  /**
+   * @brief Interval weights (as range of doubles)
+   *
+   * @see Mesh::interval_weights()
+   */
+  inline auto interval_weights([[maybe_unused]] std::size_t i) const
+  {
+    assert(i < _NIvals);
+    const double al = 1. / static_cast<double>(2 * _NIvals);
+
+    return transform(std::span<const double, _K + 1>(kNwExt.second), [al](double d) -> double { return al * d; });
+  }
+
+  /**
+   * @brief Weights (as range of doubles)
+   *
+   * @see Mesh::all_weights()
+   */
+  inline auto all_weights() const { return std::views::all(kAllNw.second); }
+
+  /**
+   * @brief Interval differentiation matrix w.r.t. [0, 1] timescale.
+   *
+   * @see Mesh::interval_diffmat()
+   */
+  inline Eigen::Matrix<double, _K + 1, _K> interval_diffmat([[maybe_unused]] std::size_t i) const
+  {
+    assert(i < _NIvals);
+    return static_cast<double>(2 * _NIvals) * DMap(kD[0].data());
+  }
+
+  /**
+   * @brief Interval differentiation matrix (unscaled).
+   *
+   * @see Mesh::interval_diffmat_unscaled()
+   */
+  inline std::pair<double, DMap> interval_diffmat_unscaled([[maybe_unused]] std::size_t i) const
+  {
+    assert(i < _NIvals);
+    return {static_cast<double>(2 * _NIvals), DMap(kD[0].data())};
+  }
+
+  /**
+   * @brief Interval Lagrange basis w.r.t. the normalized interval timescale u in [-1, 1].
+   *
+   * @see Mesh::interval_basis()
+   */
+  inline Eigen::Map<const Eigen::Matrix<double, -1, -1, Eigen::RowMajor>>
+  interval_basis(std::size_t i, bool extend = true) const
+  {
+    if (extend || i + 1 < _NIvals) {
+      return Eigen::Map<const Eigen::Matrix<double, -1, -1, Eigen::RowMajor>>(kBExt[0].data(), _K + 1, _K + 1);
+    } else {
+      return Eigen::Map<const Eigen::Matrix<double, -1, -1, Eigen::RowMajor>>(kB[0].data(), _K, _K);
+    }
+  }
+
+  /**
+   * @brief Interval integration matrix w.r.t. [0, 1] timescale.
+   *
+   * @see Mesh::interval_intmat()
+   */
+  inline Eigen::Matrix<double, _K, _K> interval_intmat([[maybe_unused]] std::size_t i) const
+  {
+    assert(i < _NIvals);
+    return (1. / static_cast<double>(2 * _NIvals)) * IMap(kI[0].data());
+  }
+
+  /**
+   * @brief Interval integration matrix (unscaled).
+   *
+   * @see Mesh::interval_intmat_unscaled()
+   */
+  inline std::pair<double, IMap> interval_intmat_unscaled([[maybe_unused]] std::size_t i) const
+  {
+    assert(i < _NIvals);
+    return {1. / static_cast<double>(2 * _NIvals), IMap(kI[0].data())};
+  }
+
+  /**
+   * @brief Find interval index that contains t
+   */
+  static constexpr std::size_t interval_find(double t)
+  {
+    if (t < 0) { return 0; }
+    return std::min(static_cast<std::size_t>(t * static_cast<double>(_NIvals)), _NIvals - 1);
+  }
+
+  /**
+   * @brief Evaluate a function
+   *
+   * @see Mesh::eval()
+   */
+  template<smooth::RnType RetT>
+  RetT eval(double t, std::ranges::range auto && r, std::size_t p = 0, bool extend = true) const
+  {
+    const std::size_t ival = interval_find(t);
+    const double u         = 2 * (t * static_cast<double>(_NIvals) - static_cast<double>(ival)) - 1;
+    const auto N_before    = static_cast<int64_t>(_K * ival);
+
+    RetT ret = RetT::Zero(std::ranges::begin(r)->size());
+
+    if (extend || ival + 1 < _NIvals) {
+      const auto W = monomial_derivative<_K>(u, p) * kBExt;  // 1 x K+1
+      for (const auto & [w, v] : zip(std::span(W[0].data(), _K + 1), r | drop(N_before))) { ret += w * v; }
+    } else {
+      const auto W = monomial_derivative<_K - 1>(u, p) * kB;  // 1 x K
+      for (const auto & [w, v] : zip(std::span(W[0].data(), _K), r | drop(N_before))) { ret += w * v; }
+    }
+
+    return ret;
+  }
+
+  /**
+   * @brief Evaluate a function at many sorted time points.
+   *
+   * @see Mesh::eval_many()
+   */
+  Eigen::MatrixXd
+  eval_many(std::ranges::sized_range auto && ts, std::ranges::range auto && r, std::size_t p = 0, bool extend = true)
+    const
+  {
+    const auto dim  = static_cast<Eigen::Index>(std::ranges::begin(r)->size());
+    const auto n_ts = static_cast<Eigen::Index>(std::ranges::size(ts));
+
+    Eigen::MatrixXd ret(dim, n_ts);
+    Eigen::Matrix<double, -1, _K + 1> V(dim, _K + 1);  // values in current interval
+
+    std::size_t ival = _NIvals;  // interval of values in V
+    for (Eigen::Index j = 0; const auto tj : ts) {
+      const double t           = static_cast<double>(tj);
+      const std::size_t ival_j = interval_find(t);
+      const bool ext           = extend || ival_j + 1 < _NIvals;
+
+      if (ival_j != ival) {
+        ival = ival_j;
+        V.setZero();
+        for (const auto & [c, v] : zip(iota(0u, ext ? _K + 1 : _K), r | drop(static_cast<int64_t>(_K * ival)))) {
+          V.col(static_cast<Eigen::Index>(c)) = v;
+        }
+      }
+
+      const double u = 2 * (t * static_cast<double>(_NIvals) - static_cast<double>(ival)) - 1;
+      if (ext) {
+        const auto W = monomial_derivative<_K>(u, p) * kBExt;
+        ret.col(j).noalias() = V * Eigen::Map<const Eigen::Vector<double, _K + 1>>(W[0].data());
+      } else {
+        const auto W = monomial_derivative<_K - 1>(u, p) * kB;
+        ret.col(j).noalias() = V.template leftCols<_K>() * Eigen::Map<const Eigen::Vector<double, _K>>(W[0].data());
+      }
+      ++j;
+    }
+
+    return ret;
+  }
 };
 
-/// @brief MeshType is a specialization of Mesh
+/// @brief MeshType is a specialization of Mesh or FixedMesh
 template<typename T>
-concept MeshType = traits::is_specialization_of_sizet_v<std::decay_t<T>, Mesh>;
+concept MeshType = traits::is_specialization_of_sizet_v<std::decay_t<T>, Mesh>
+                || traits::is_specialization_of_sizet_v<std::decay_t<T>, FixedMesh>;
 
 }  // namespace smooth::feedback
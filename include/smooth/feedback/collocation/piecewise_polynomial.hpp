@@ -0,0 +1,268 @@
+// Copyright (C) 2022 Petter Nilsson. MIT License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Piecewise polynomial trajectory in monomial form.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "mesh.hpp"
+
+namespace smooth::feedback {
+
+/**
+ * @brief Piecewise polynomial function \f$ \mathbb{R} \rightarrow \mathbb{R}^{Dim} \f$.
+ *
+ * @tparam Dim output dimension (-1 for dynamic)
+ *
+ * Monomial coefficients of all intervals are stored contiguously, and the polynomial in each interval is
+ * evaluated with Horner's scheme w.r.t. a normalized interval timescale. An Evaluator obtained via evaluator()
+ * caches the index of the most recently evaluated interval so that monotone queries do not require a search.
+ *
+ * Times before the first (after the last) interval are extrapolated with the first (last) polynomial.
+ *
+ * @note Const member functions do not modify the instance and can be called concurrently.
+ */
+template<int Dim = -1>
+class PiecewisePolynomial
+{
+public:
+  /// @brief Output type
+  using Vec = Eigen::Vector<double, Dim>;
+
+  /// @brief Default constructor creates an empty polynomial
+  PiecewisePolynomial() = default;
+
+  /**
+   * @brief Create piecewise polynomial that interpolates values at the nodes of a collocation mesh.
+   *
+   * @param mesh collocation mesh
+   * @param vals values at mesh nodes (size Dim x N [extend=false] or Dim x N+1 [extend=true])
+   * @param t0 time corresponding to 0 on the mesh timescale
+   * @param tf time corresponding to 1 on the mesh timescale
+   * @param extend set to true if a value is provided for the mesh endpoint
+   *
+   * The result is equal to Mesh::eval() at all times.
+   *
+   * @note Allocates heap memory.
+   */
+  template<typename Derived>
+  PiecewisePolynomial(
+    const MeshType auto & mesh, const Eigen::MatrixBase<Derived> & vals, double t0, double tf, bool extend = true)
+  {
+    const std::size_t N_ivals = mesh.N_ivals();
+
+    assert(vals.cols() == static_cast<Eigen::Index>(mesh.N_colloc() + (extend ? 1 : 0)));
+    assert(Dim == -1 || vals.rows() == Dim);
+
+    // count coefficients
+    std::size_t N_coefs = 0;
+    for (auto i = 0u; i < N_ivals; ++i) {
+      N_coefs += mesh.N_colloc_ival(i) + (extend || i + 1 < N_ivals ? 1 : 0);
+    }
+
+    breaks_.resize(N_ivals + 1);
+    coef_beg_.resize(N_ivals + 1);
+    scale_.resize(N_ivals);
+    coefs_.resize(vals.rows(), static_cast<Eigen::Index>(N_coefs));
+
+    const double dt = tf - t0;
+
+    Eigen::Index val_beg = 0, coef_beg = 0;
+    for (auto i = 0u; i < N_ivals; ++i) {
+      const auto B      = mesh.interval_basis(i, extend);
+      const auto n_coef = B.rows();
+
+      breaks_[i]   = t0 + dt * mesh.interval_start(i);
+      coef_beg_[i] = static_cast<std::size_t>(coef_beg);
+
+      // coefficients w.r.t. u in [-1, 1]
+      coefs_.middleCols(coef_beg, n_coef).noalias() = vals.middleCols(val_beg, n_coef) * B.transpose();
+
+      val_beg += static_cast<Eigen::Index>(mesh.N_colloc_ival(i));
+      coef_beg += n_coef;
+    }
+    breaks_[N_ivals]   = tf;
+    coef_beg_[N_ivals] = static_cast<std::size_t>(coef_beg);
+
+    for (auto i = 0u; i < N_ivals; ++i) { scale_[i] = 2. / (breaks_[i + 1] - breaks_[i]); }
+  }
+
+  /// @brief Default copy constructor
+  PiecewisePolynomial(const PiecewisePolynomial &) = default;
+  /// @brief Default move constructor
+  PiecewisePolynomial(PiecewisePolynomial &&) = default;
+  /// @brief Default copy assignment
+  PiecewisePolynomial & operator=(const PiecewisePolynomial &) = default;
+  /// @brief Default move assignment
+  PiecewisePolynomial & operator=(PiecewisePolynomial &&) = default;
+  /// @brief Default destructor
+  ~PiecewisePolynomial() = default;
+
+  /// @brief Number of polynomial pieces
+  std::size_t N_ivals() const { return scale_.size(); }
+
+  /// @brief Output dimension
+  Eigen::Index dim() const { return coefs_.rows(); }
+
+  /// @brief Start time
+  double t0() const { return breaks_.front(); }
+
+  /// @brief End time
+  double tf() const { return breaks_.back(); }
+
+  /**
+   * @brief Find index of the interval that contains t.
+   *
+   * @param t time
+   * @param cursor index of a previously found interval, updated to the result
+   *
+   * Checks the interval at cursor and its successor before falling back to a binary search.
+   */
+  std::size_t interval_find(double t, std::size_t & cursor) const
+  {
+    assert(N_ivals() > 0);
+
+    const std::size_t N = N_ivals();
+
+    if (cursor < N && breaks_[cursor] <= t) {
+      if (cursor + 1 == N || t < breaks_[cursor + 1]) { return cursor; }
+      if (cursor + 2 == N || t < breaks_[cursor + 2]) { return ++cursor; }
+    }
+
+    // breaks_ has size N + 1, search for first interval start larger than t among the first N
+    const auto it = std::upper_bound(breaks_.begin() + 1, breaks_.begin() + static_cast<std::ptrdiff_t>(N), t);
+    cursor        = static_cast<std::size_t>(std::distance(breaks_.begin() + 1, it));
+    return cursor;
+  }
+
+  /**
+   * @brief Find index of the interval that contains t (binary search).
+   */
+  std::size_t interval_find(double t) const
+  {
+    std::size_t cursor = N_ivals();
+    return interval_find(t, cursor);
+  }
+
+  /**
+   * @brief Evaluate polynomial at time t.
+   */
+  Vec operator()(double t) const { return eval_ival(interval_find(t), t); }
+
+  /**
+   * @brief Evaluate polynomial at time t.
+   *
+   * @param t time
+   * @param cursor index of a previously found interval, updated to the interval that contains t
+   */
+  Vec operator()(double t, std::size_t & cursor) const { return eval_ival(interval_find(t, cursor), t); }
+
+  /**
+   * @brief Evaluator of a PiecewisePolynomial that caches the most recently evaluated interval.
+   *
+   * Each caller (e.g. thread) should own its evaluator. The polynomial must outlive the evaluator.
+   */
+  class Evaluator
+  {
+  public:
+    /// @brief Create evaluator of polynomial
+    explicit Evaluator(const PiecewisePolynomial & poly) : poly_(&poly) {}
+
+    /// @brief Evaluate polynomial at time t
+    Vec operator()(double t) { return (*poly_)(t, cursor_); }
+
+    /// @brief Index of the most recently evaluated interval
+    std::size_t interval() const { return cursor_; }
+
+  private:
+    const PiecewisePolynomial * poly_;
+    std::size_t cursor_{0};
+  };
+
+  /// @brief Create an evaluator that is efficient for monotone queries
+  Evaluator evaluator() const { return Evaluator(*this); }
+
+  /**
+   * @brief Move polynomial into a callable t -> Vec that owns an interval cursor.
+   *
+   * Intended for type erasure (e.g. in a std::function), monotone queries of the callable do not require a search.
+   *
+   * @note The callable modifies its cursor and must not be called concurrently.
+   */
+  auto into_callable() &&
+  {
+    return [poly = std::move(*this), cursor = std::size_t{0}](double t) mutable -> Vec { return poly(t, cursor); };
+  }
+
+  /**
+   * @brief Evaluate polynomial at many time points.
+   *
+   * @param[in] ts time points
+   * @param[out] out output values, must have size dim() x ts.size()
+   *
+   * Consecutive time points that fall in the same interval are evaluated together with vectorized
+   * array operations, so sorted time points are most efficient.
+   */
+  void eval(const Eigen::Ref<const Eigen::VectorXd> & ts, Eigen::Ref<Eigen::Matrix<double, Dim, -1>> out) const
+  {
+    assert(out.rows() == dim());
+    assert(out.cols() == ts.size());
+
+    std::size_t cursor = 0;
+
+    Eigen::Index j0 = 0;
+    while (j0 < ts.size()) {
+      const std::size_t i = interval_find(ts(j0), cursor);
+
+      // extent of batch in interval i
+      Eigen::Index j1 = j0 + 1;
+      while (j1 < ts.size() && interval_find(ts(j1), cursor) == i) { ++j1; }
+
+      const auto b0 = static_cast<Eigen::Index>(coef_beg_[i]);
+      const auto n  = static_cast<Eigen::Index>(coef_beg_[i + 1]) - b0;
+
+      const Eigen::ArrayXd us = scale_[i] * (ts.segment(j0, j1 - j0).array() - breaks_[i]) - 1;
+
+      auto out_b = out.middleCols(j0, j1 - j0);
+      out_b.colwise() = coefs_.col(b0 + n - 1);
+      for (auto k = n - 2; k >= 0; --k) {
+        out_b.array().rowwise() *= us.transpose();
+        out_b.colwise() += coefs_.col(b0 + k);
+      }
+
+      j0 = j1;
+    }
+  }
+
+private:
+  /// @brief Evaluate polynomial of interval i at time t
+  Vec eval_ival(std::size_t i, double t) const
+  {
+    const auto b0 = static_cast<Eigen::Index>(coef_beg_[i]);
+    const auto n  = static_cast<Eigen::Index>(coef_beg_[i + 1]) - b0;
+    const double u = scale_[i] * (t - breaks_[i]) - 1;
+
+    Vec ret = coefs_.col(b0 + n - 1);
+    for (auto k = n - 2; k >= 0; --k) { ret = u * ret + coefs_.col(b0 + k); }
+    return ret;
+  }
+
+  // interval start times (and end time), size N_ivals + 1
+  std::vector<double> breaks_;
+  // index of first coefficient of each interval (and total number of coefficients), size N_ivals + 1
+  std::vector<std::size_t> coef_beg_;
+  // 2 / interval lengths, size N_ivals
+  std::vector<double> scale_;
+  // monomial coefficients in increasing order for all intervals
+  Eigen::Matrix<double, Dim, -1> coefs_;
+};
+
+}  // namespace smooth::feedback
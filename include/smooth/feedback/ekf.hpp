@@ -8,8 +8,121 @@
 #include <smooth/concepts/lie_group.hpp>
 #include <smooth/diff.hpp>
 
+#include <cmath>
+#include <optional>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+
 namespace smooth::feedback {
 
+// \cond
+namespace detail {
+
+/**
+ * @brief Matrix exponential via scaling and squaring of a truncated Taylor series.
+ *
+ * The matrix is scaled s.t. its 1-norm is at most 1/2, for which a Taylor series of order 13 is accurate to
+ * double precision.
+ */
+template<typename Derived>
+auto expm(const Eigen::MatrixBase<Derived> & M)
+{
+  using Scalar = typename Derived::Scalar;
+  using Mat    = Eigen::Matrix<Scalar, Derived::RowsAtCompileTime, Derived::ColsAtCompileTime>;
+
+  const Scalar nrm = M.cwiseAbs().colwise().sum().maxCoeff();
+  const int s      = nrm > Scalar(0.5) ? static_cast<int>(std::ceil(std::log2(nrm / Scalar(0.5)))) : 0;
+
+  const Mat X = M / std::pow(Scalar(2), s);
+
+  const Mat I = Mat::Identity(M.rows(), M.cols());
+  Mat E       = I + X / 13;
+  for (int k = 12; k > 0; --k) { E = I + X * E / k; }
+  for (int k = 0; k < s; ++k) { E = E * E; }
+  return E;
+}
+
+/**
+ * @brief Cached discretization of linear dynamics \f$ \dot x = A x + w \f$, \f$ w \sim \mathcal N(0, Q) \f$.
+ *
+ * Holds the transition matrix \f$ \Phi = \exp(A \tau) \f$ and the discrete noise covariance \f$ Q_d =
+ * \int_0^\tau \exp(A s) Q \exp(A s)^T \mathrm{d}s \f$.
+ */
+template<typename Scalar, int N>
+struct DiscreteTransition
+{
+  /// @brief Matrix type
+  using Mat = Eigen::Matrix<Scalar, N, N>;
+
+  /// @brief Time step of cached values
+  Scalar tau{-1};
+  /// @brief Dynamics matrix of cached values
+  Mat A{Mat::Zero()};
+  /// @brief Noise covariance of cached values (only upper triangular part is used)
+  Mat Q{Mat::Zero()};
+  /// @brief Transition matrix
+  Mat Phi{Mat::Identity()};
+  /// @brief Discrete noise covariance
+  Mat Qd{Mat::Zero()};
+
+  /**
+   * @brief Update transition for new dynamics via a Van Loan block exponential.
+   *
+   * \f[
+   *   \exp \left( \begin{bmatrix} -A & Q \\ 0 & A^T \end{bmatrix} \tau \right)
+   *   = \begin{bmatrix} \star & \Phi^{-1} Q_d \\ 0 & \Phi^T \end{bmatrix}
+   * \f]
+   *
+   * @return true if the transition was re-computed, false if the cached value was re-used
+   */
+  template<typename ADer, typename QDer>
+  bool update(const Eigen::MatrixBase<ADer> & A_new, const Eigen::MatrixBase<QDer> & Q_new, Scalar tau_new)
+  {
+    if (tau_new == tau && A_new == A && Q_new == Q) { return false; }
+
+    tau = tau_new;
+    A   = A_new;
+    Q   = Q_new;
+
+    Eigen::Matrix<Scalar, 2 * N, 2 * N> M;
+    M.template topLeftCorner<N, N>()     = -tau * A;
+    M.template topRightCorner<N, N>()    = tau * Q.template selfadjointView<Eigen::Upper>().toDenseMatrix();
+    M.template bottomLeftCorner<N, N>()  = Mat::Zero();
+    M.template bottomRightCorner<N, N>() = tau * A.transpose();
+
+    const Eigen::Matrix<Scalar, 2 * N, 2 * N> E = expm(M);
+
+    Phi = E.template bottomRightCorner<N, N>().transpose();
+    Qd  = Phi * E.template topRightCorner<N, N>();
+    Qd  = Qd.template selfadjointView<Eigen::Upper>();
+
+    return true;
+  }
+};
+
+/// @brief Total number of rows in a tuple of linearized measurements.
+template<typename Lins>
+struct ekf_stacked_rows;
+
+template<typename... Lin>
+struct ekf_stacked_rows<std::tuple<Lin...>>
+{
+  static constexpr int value = (std::tuple_element_t<0, Lin>::RowsAtCompileTime + ... + 0);
+};
+
+}  // namespace detail
+// \endcond
+
+/**
+ * @brief Method for EKF::update_batch().
+ */
+enum class EKFBatchMode {
+  Auto,        ///< @brief Sequential if all measurement covariances are diagonal, otherwise Stacked
+  Stacked,     ///< @brief One update with stacked measurements and block-diagonal covariance
+  Sequential,  ///< @brief One scalar update per measurement component (no matrix inversion)
+};
+
 /**
  * @brief Extended Kalman filter on Lie groups.
  *
@@ -58,6 +171,11 @@ public:
    */
   CovT covariance() const { return P_; }
 
+  /**
+   * @brief Access transition matrix \f$ \Phi \f$ of the error dynamics from the last call to predict_discrete().
+   */
+  const CovT & transition() const { return trans_.Phi; }
+
   /**
    * @brief Propagate EKF through dynamics \f$ \mathrm{d}^r x_t = f(t, x) \f$ with covariance
    * \f$Q\f$ over a time interval \f$ [0, \tau] \f$.
@@ -102,6 +220,53 @@ public:
     sst_.do_step(state_ode, g_hat_, t, tau - t);
   }
 
+  /**
+   * @brief Propagate EKF through dynamics \f$ \mathrm{d}^r x_t = f(t, x) \f$ with covariance
+   * \f$Q\f$ over a time interval \f$ [0, \tau] \f$ using a single linearization.
+   *
+   * The dynamics are linearized once at the current estimate as \f$ A = -\mathrm{ad}_{f} + \mathrm{d}^r f_x \f$,
+   * after which the covariance is propagated in closed form as
+   * \f[
+   *   P \leftarrow \Phi P \Phi^T + Q_d, \quad \Phi = \exp(A \tau), \quad
+   *   Q_d = \int_0^\tau \exp(A s) Q \exp(A s)^T \mathrm{d}s,
+   * \f]
+   * where \f$ \Phi \f$ and \f$ Q_d \f$ are computed with a Van Loan block exponential. They are cached and
+   * re-used in subsequent calls with the same linearization, Q, and tau (e.g. for linear time-invariant systems).
+   *
+   * Compared to predict() this requires a single Jacobian evaluation, but ignores variations of the linearization
+   * over the interval.
+   *
+   * @param f right-hand side of the dynamics (see predict())
+   * @param Q process covariance (see predict())
+   * @param tau amount of time to propagate
+   * @param dt maximal ODE solver step size for the state (defaults to \p tau, i.e. one step)
+   *
+   * @note Only the upper triangular part of Q is used.
+   */
+  template<typename F, typename QDer>
+  void predict_discrete(F && f, const Eigen::MatrixBase<QDer> & Q, Scalar<G> tau, std::optional<Scalar<G>> dt = {})
+  {
+    const auto state_ode = [&f](const G & g, Tangent<G> & dg, Scalar<G> t) { dg = f(t, g); };
+
+    const auto f_x = [&f]<typename _T>(const CastT<_T, G> & x) -> Tangent<CastT<_T, G>> {
+      return f(Scalar<G>(0), x);
+    };
+    const auto [fv, dr] = diff::dr<1, DiffType>(f_x, wrt(g_hat_));
+
+    trans_.update(-ad<G>(fv) + dr, Q, tau);
+
+    P_ = (trans_.Phi * P_.template selfadjointView<Eigen::Upper>() * trans_.Phi.transpose() + trans_.Qd)
+           .template selfadjointView<Eigen::Upper>();
+
+    Scalar<G> t          = 0;
+    const Scalar<G> dt_v = dt.value_or(2 * tau);
+    while (t + dt_v < tau) {
+      sst_.do_step(state_ode, g_hat_, t, dt_v);
+      t += dt_v;
+    }
+    sst_.do_step(state_ode, g_hat_, t, tau - t);
+  }
+
   /**
    * @brief Update EKF with a measurement \f$y = h(x) + w\f$ where \f$w \sim \mathcal N(0, R)\f$.
    *
@@ -126,6 +291,151 @@ public:
 
     static_assert(Ny > 0, "h(x) must be statically sized");
 
+    g_hat_ += stacked_update<Ny>(y - hval, H, R);
+  }
+
+  /**
+   * @brief Update EKF with several measurements \f$y_i = h_i(x) + w_i\f$ where \f$w_i \sim \mathcal N(0, R_i)\f$.
+   *
+   * All measurement functions are linearized at the current estimate, and the result is equal to a single
+   * update() with stacked measurements and block-diagonal covariance. Depending on mode the update is computed
+   * - Stacked: as a single update that solves for the Kalman gain with the stacked innovation covariance, or
+   * - Sequential: as one scalar update per measurement component (after whitening if \f$ R_i \f$ is not diagonal),
+   * which avoids forming and decomposing the innovation covariance and requires \f$ O(n_y n^2) \f$ operations.
+   *
+   * @param ms tuple of measurement models, each model is a tuple-like \f$ (h_i, y_i, R_i) \f$ with arguments as in
+   * update() (e.g. created with std::forward_as_tuple()).
+   * @param mode update method
+   */
+  template<typename... Ms>
+  void update_batch(const std::tuple<Ms...> & ms, EKFBatchMode mode = EKFBatchMode::Auto)
+  {
+    const auto lins = std::apply([this](const auto &... m) { return std::make_tuple(linearize(m)...); }, ms);
+
+    if (mode == EKFBatchMode::Auto) {
+      const bool diag = std::apply([](const auto &... l) { return (std::get<2>(l).isDiagonal() && ...); }, lins);
+      mode            = diag ? EKFBatchMode::Sequential : EKFBatchMode::Stacked;
+    }
+
+    if (mode == EKFBatchMode::Sequential) {
+      Tangent<G> dx = Tangent<G>::Zero();
+      const auto step = [&](const auto & l) { sequential_update(dx, std::get<0>(l), std::get<1>(l), std::get<2>(l)); };
+      std::apply([&](const auto &... l) { (step(l), ...); }, lins);
+      g_hat_ += dx;
+    } else {
+      static constexpr int Ny = detail::ekf_stacked_rows<std::decay_t<decltype(lins)>>::value;
+
+      Eigen::Matrix<Scalar<G>, Ny, 1> r;
+      Eigen::Matrix<Scalar<G>, Ny, Dof<G>> H;
+      Eigen::Matrix<Scalar<G>, Ny, Ny> R = Eigen::Matrix<Scalar<G>, Ny, Ny>::Zero();
+
+      Eigen::Index row = 0;
+
+      const auto insert = [&](const auto & l) {
+        constexpr auto Nyi = std::tuple_element_t<0, std::decay_t<decltype(l)>>::RowsAtCompileTime;
+
+        r.template segment<Nyi>(row)         = std::get<0>(l);
+        H.template middleRows<Nyi>(row)      = std::get<1>(l);
+        R.template block<Nyi, Nyi>(row, row) = std::get<2>(l);
+        row += Nyi;
+      };
+      std::apply([&](const auto &... l) { (insert(l), ...); }, lins);
+
+      g_hat_ += stacked_update<Ny>(r, H, R);
+    }
+  }
+
+  /**
+   * @brief Update EKF with a range of measurements of the same type.
+   *
+   * Range version of update_batch(), useful e.g. for a variable number of landmark observations.
+   *
+   * @param ms range of measurement models, each model is a tuple-like \f$ (h_i, y_i, R_i) \f$
+   * @param mode update method
+   *
+   * @note Mode Stacked allocates memory for the stacked problem.
+   */
+  template<std::ranges::range Rng>
+  void update_batch(const Rng & ms, EKFBatchMode mode = EKFBatchMode::Auto)
+  {
+    if (mode == EKFBatchMode::Auto) {
+      bool diag = true;
+      for (const auto & m : ms) { diag = diag && std::get<2>(m).isDiagonal(); }
+      mode = diag ? EKFBatchMode::Sequential : EKFBatchMode::Stacked;
+    }
+
+    if (mode == EKFBatchMode::Sequential) {
+      Tangent<G> dx = Tangent<G>::Zero();
+      for (const auto & m : ms) {
+        const auto [r, H, R] = linearize(m);
+        sequential_update(dx, r, H, R);
+      }
+      g_hat_ += dx;
+    } else {
+      using Lin = decltype(linearize(*std::ranges::begin(ms)));
+
+      static constexpr int Nyi = std::tuple_element_t<0, Lin>::RowsAtCompileTime;
+
+      const auto Ny = static_cast<Eigen::Index>(Nyi * std::ranges::distance(ms));
+
+      Eigen::Matrix<Scalar<G>, -1, 1> r(Ny);
+      Eigen::Matrix<Scalar<G>, -1, Dof<G>> H(Ny, Dof<G>);
+      Eigen::Matrix<Scalar<G>, -1, -1> R = Eigen::Matrix<Scalar<G>, -1, -1>::Zero(Ny, Ny);
+
+      Eigen::Index row = 0;
+      for (const auto & m : ms) {
+        const auto [ri, Hi, Ri] = linearize(m);
+
+        r.template segment<Nyi>(row)         = ri;
+        H.template middleRows<Nyi>(row)      = Hi;
+        R.template block<Nyi, Nyi>(row, row) = Ri;
+        row += Nyi;
+      }
+
+      g_hat_ += stacked_update<-1>(r, H, R);
+    }
+  }
+
+private:
+  /**
+   * @brief Linearize measurement model (h, y, R) at current estimate.
+   *
+   * @return tuple (y - h(x), dh/dx, R)
+   */
+  template<typename M>
+  auto linearize(const M & m) const
+  {
+    const auto & h = std::get<0>(m);
+    const auto & y = std::get<1>(m);
+    const auto & R = std::get<2>(m);
+
+    const auto [hval, H] = diff::dr<1, DiffType>(h, wrt(g_hat_));
+
+    using Result = std::decay_t<decltype(hval)>;
+
+    static_assert(Manifold<Result>, "h(x) is not a Manifold");
+
+    static constexpr Eigen::Index Ny = Dof<Result>;
+
+    static_assert(Ny > 0, "h(x) must be statically sized");
+
+    return std::make_tuple(
+      Eigen::Matrix<Scalar<G>, Ny, 1>(y - hval),
+      Eigen::Matrix<Scalar<G>, Ny, Dof<G>>(H),
+      Eigen::Matrix<Scalar<G>, Ny, Ny>(R.template selfadjointView<Eigen::Upper>()));
+  }
+
+  /**
+   * @brief Kalman update of covariance for a linearized measurement.
+   *
+   * @return estimate update
+   */
+  template<int Ny, typename RDev>
+  Tangent<G> stacked_update(
+    const Eigen::Matrix<Scalar<G>, Ny, 1> & r,
+    const Eigen::Matrix<Scalar<G>, Ny, Dof<G>> & H,
+    const Eigen::MatrixBase<RDev> & R)
+  {
     const Eigen::Matrix<Scalar<G>, Ny, Ny> S =
       (H * P_.template selfadjointView<Eigen::Upper>() * H.transpose() + R).template triangularView<Eigen::Upper>();
 
@@ -133,12 +443,46 @@ public:
     const Eigen::Matrix<Scalar<G>, Dof<G>, Ny> K =
       S.template selfadjointView<Eigen::Upper>().ldlt().solve(H * P_).transpose();
 
-    // update estimate and covariance
-    g_hat_ += K * (y - hval);
+    // update covariance
     P_ = ((CovT::Identity() - K * H) * P_).template selfadjointView<Eigen::Upper>();
+
+    return K * r;
+  }
+
+  /**
+   * @brief Sequential scalar Kalman updates for a linearized measurement.
+   *
+   * @param[in, out] dx accumulated estimate update (measurements are linearized at estimate before update)
+   */
+  template<int Ny>
+  void sequential_update(
+    Tangent<G> & dx,
+    const Eigen::Matrix<Scalar<G>, Ny, 1> & r,
+    const Eigen::Matrix<Scalar<G>, Ny, Dof<G>> & H,
+    const Eigen::Matrix<Scalar<G>, Ny, Ny> & R)
+  {
+    const bool diag = R.isDiagonal();
+
+    // whiten measurement if R is not diagonal
+    Eigen::Matrix<Scalar<G>, Ny, 1> rw      = r;
+    Eigen::Matrix<Scalar<G>, Ny, Dof<G>> Hw = H;
+    Eigen::Matrix<Scalar<G>, Ny, 1> var     = R.diagonal();
+    if (!diag) {
+      const Eigen::LLT<Eigen::Matrix<Scalar<G>, Ny, Ny>> llt(R);
+      llt.matrixL().solveInPlace(rw);
+      llt.matrixL().solveInPlace(Hw);
+      var.setOnes();
+    }
+
+    for (auto j = 0; j < Ny; ++j) {
+      const Tangent<G> PHt = P_ * Hw.row(j).transpose();
+      const Tangent<G> K   = PHt / (Hw.row(j).dot(PHt) + var(j));
+
+      dx += K * (rw(j) - Hw.row(j).dot(dx));
+      P_.noalias() -= K * PHt.transpose();
+    }
   }
 
-private:
   // filter estimate and covariance
   G g_hat_ = Default<G>();
   CovT P_  = CovT::Identity();
@@ -146,6 +490,9 @@ private:
   // steppers for numerical ODE solutions
   Stpr<G, Scalar<G>, Tangent<G>, Scalar<G>, boost::numeric::odeint::vector_space_algebra> sst_{};
   Stpr<CovT, Scalar<G>, CovT, Scalar<G>, boost::numeric::odeint::vector_space_algebra> cst_{};
+
+  // cached discretization for predict_discrete()
+  detail::DiscreteTransition<Scalar<G>, Dof<G>> trans_{};
 };
 
 }  // namespace smooth::feedback
@@ -0,0 +1,263 @@
+// Copyright (C) 2022 Petter Nilsson. MIT License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Bank of extended Kalman filters with structure-of-arrays covariance storage.
+ */
+
+#include <Eigen/Core>
+#include <smooth/concepts/lie_group.hpp>
+#include <smooth/diff.hpp>
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <optional>
+#include <type_traits>
+
+namespace smooth::feedback {
+
+/**
+ * @brief Bank of N extended Kalman filters on a Lie group G with shared dynamics and process covariance.
+ *
+ * Covariances (and linearizations) are stored in structure-of-arrays layout: coefficient \f$ (r, c) \f$ of all N
+ * filters is a contiguous array of length N. All covariance operations of predict() and update() are carried out
+ * coefficient-wise on such arrays, which lets the compiler run N filters in SIMD lanes. Jacobians are evaluated
+ * filter by filter.
+ *
+ * The result of a bank is equal to N independent filters of type EKF<G, DiffType, boost::numeric::odeint::euler>.
+ *
+ * @tparam G \p smooth::LieGroup type
+ * @tparam N number of filters
+ * @tparam DiffType \p smooth::diff::Type method for calculating derivatives
+ */
+template<LieGroup G, int N, diff::Type DiffType = diff::Type::Default>
+  requires(Dof<G> > 0 && N > 0)
+class EKFBank
+{
+public:
+  //! Covariance type of a single filter.
+  using CovT = Eigen::Matrix<Scalar<G>, Dof<G>, Dof<G>>;
+
+  //! Array with one value per filter.
+  using Lanes = Eigen::Array<Scalar<G>, N, 1>;
+
+  //! Array with one flag per filter.
+  using Mask = Eigen::Array<bool, N, 1>;
+
+  /**
+   * @brief Create bank with all filters at the default value with identity covariance.
+   */
+  EKFBank() : P_(N, Dof<G> * Dof<G>), A_(N, Dof<G> * Dof<G>), dP_(N, Dof<G> * Dof<G>), dg_(N, Dof<G>)
+  {
+    g_.fill(Default<G>());
+    for (auto i = 0; i < N; ++i) { reset(i, Default<G>(), CovT::Identity()); }
+  }
+
+  /**
+   * @brief Reset the state of filter i.
+   *
+   * @param i filter index
+   * @param g filter value
+   * @param P filter covariance (only upper triangular part is used)
+   */
+  void reset(Eigen::Index i, const G & g, const CovT & P)
+  {
+    assert(i < N);
+    g_[static_cast<std::size_t>(i)] = g;
+    for (auto c = 0; c < Dof<G>; ++c) {
+      for (auto r = 0; r <= c; ++r) {
+        P_(i, idx(r, c)) = P(r, c);
+        P_(i, idx(c, r)) = P(r, c);
+      }
+    }
+  }
+
+  /**
+   * @brief Access state estimate of filter i.
+   */
+  G estimate(Eigen::Index i) const { return g_[static_cast<std::size_t>(i)]; }
+
+  /**
+   * @brief Access covariance of filter i.
+   */
+  CovT covariance(Eigen::Index i) const
+  {
+    CovT ret;
+    for (auto c = 0; c < Dof<G>; ++c) {
+      for (auto r = 0; r < Dof<G>; ++r) { ret(r, c) = P_(i, idx(r, c)); }
+    }
+    return ret;
+  }
+
+  /**
+   * @brief Propagate all filters through dynamics \f$ \mathrm{d}^r x_t = f(t, x) \f$ with covariance \f$Q\f$ over
+   * a time interval \f$ [0, \tau] \f$.
+   *
+   * Uses explicit Euler steps for both state and covariance.
+   *
+   * @param f right-hand side of the dynamics (see EKF::predict())
+   * @param Q process covariance (see EKF::predict())
+   * @param tau amount of time to propagate
+   * @param dt maximal step size (defaults to \p tau, i.e. one step)
+   */
+  template<typename F, typename QDer>
+  void predict(F && f, const Eigen::MatrixBase<QDer> & Q, Scalar<G> tau, std::optional<Scalar<G>> dt = {})
+  {
+    Scalar<G> t          = 0;
+    const Scalar<G> dt_v = dt.value_or(2 * tau);
+    while (t + dt_v < tau) {
+      euler_step(f, Q, t, dt_v);
+      t += dt_v;
+    }
+    euler_step(f, Q, t, tau - t);
+  }
+
+  /**
+   * @brief Update filters with measurements \f$y_i = h(x_i) + w_i\f$ where \f$w_i \sim \mathcal N(0, R)\f$.
+   *
+   * @param h measurement function \f$ h : \mathbb{G} \rightarrow \mathbb{Y} \f$ (see EKF::update())
+   * @param ys measurement values, one per filter
+   * @param R measurement covariance (only upper triangular part is used)
+   * @param mask filters to update, filters where mask is false are left unchanged and their
+   * measurement values are not used
+   *
+   * @note Allocates memory on the first call with a given measurement dimension.
+   */
+  template<typename F, typename RDev, Manifold Y = std::invoke_result_t<F, G>>
+  void update(
+    F && h, const std::array<Y, N> & ys, const Eigen::MatrixBase<RDev> & R, const Mask & mask = Mask::Constant(true))
+  {
+    static constexpr int Nx = Dof<G>;
+    static constexpr int Ny = Dof<Y>;
+
+    static_assert(Ny > 0, "h(x) must be statically sized");
+
+    // linearize active filters, inactive filters get zero Jacobian and residual
+    r_.setZero(N, Ny);
+    H_.setZero(N, Ny * Nx);
+    HP_.setZero(N, Ny * Nx);
+    L_.setZero(N, Ny * Ny);
+
+    for (auto i = 0; i < N; ++i) {
+      if (!mask(i)) { continue; }
+      const auto [hval, Hi] = diff::dr<1, DiffType>(h, wrt(g_[static_cast<std::size_t>(i)]));
+      const Tangent<Y> ri   = ys[static_cast<std::size_t>(i)] - hval;
+      for (auto a = 0; a < Ny; ++a) {
+        r_(i, a) = ri(a);
+        for (auto k = 0; k < Nx; ++k) { H_(i, a + Ny * k) = Hi(a, k); }
+      }
+    }
+
+    // HP = H * P
+    for (auto c = 0; c < Nx; ++c) {
+      for (auto a = 0; a < Ny; ++a) {
+        for (auto k = 0; k < Nx; ++k) { HP_.col(a + Ny * c) += H_.col(a + Ny * k) * P_.col(idx(k, c)); }
+      }
+    }
+
+    // lower Cholesky factor L of S = H P H' + R (in place of S), inactive filters get L = I
+    for (auto b = 0; b < Ny; ++b) {
+      for (auto a = b; a < Ny; ++a) {
+        Lanes s = Lanes::Constant(R(b, a));
+        for (auto k = 0; k < Nx; ++k) { s += HP_.col(a + Ny * k) * H_.col(b + Ny * k); }
+        for (auto k = 0; k < b; ++k) { s -= L_.col(a + Ny * k) * L_.col(b + Ny * k); }
+        if (a == b) {
+          L_.col(a + Ny * b) = mask.select(s.sqrt(), Scalar<G>(1));
+        } else {
+          L_.col(a + Ny * b) = mask.select(s / L_.col(b + Ny * b), Scalar<G>(0));
+        }
+      }
+    }
+
+    // transposed Kalman gain K' = S^{-1} H P, stored in place of HP
+    Kt_ = HP_;
+    for (auto c = 0; c < Nx; ++c) {
+      for (auto a = 0; a < Ny; ++a) {
+        for (auto k = 0; k < a; ++k) { Kt_.col(a + Ny * c) -= L_.col(a + Ny * k) * Kt_.col(k + Ny * c); }
+        Kt_.col(a + Ny * c) /= L_.col(a + Ny * a);
+      }
+      for (auto a = Ny; a-- > 0;) {
+        for (auto k = a + 1; k < Ny; ++k) { Kt_.col(a + Ny * c) -= L_.col(k + Ny * a) * Kt_.col(k + Ny * c); }
+        Kt_.col(a + Ny * c) /= L_.col(a + Ny * a);
+      }
+    }
+
+    // covariance P -= K H P
+    for (auto c = 0; c < Nx; ++c) {
+      for (auto rr = 0; rr <= c; ++rr) {
+        Lanes d = Lanes::Zero();
+        for (auto a = 0; a < Ny; ++a) { d += Kt_.col(a + Ny * rr) * HP_.col(a + Ny * c); }
+        P_.col(idx(rr, c)) -= d;
+        if (rr != c) { P_.col(idx(c, rr)) = P_.col(idx(rr, c)); }
+      }
+    }
+
+    // state g += K r
+    dg_.setZero();
+    for (auto k = 0; k < Nx; ++k) {
+      for (auto a = 0; a < Ny; ++a) { dg_.col(k) += Kt_.col(a + Ny * k) * r_.col(a); }
+    }
+    for (auto i = 0; i < N; ++i) {
+      if (mask(i)) { g_[static_cast<std::size_t>(i)] += Tangent<G>(dg_.row(i).transpose()); }
+    }
+  }
+
+private:
+  /// @brief Column of coefficient (r, c) in SoA storage
+  static constexpr Eigen::Index idx(Eigen::Index r, Eigen::Index c) { return r + Dof<G> * c; }
+
+  /// @brief Single Euler step of states and covariances
+  template<typename F, typename QDer>
+  void euler_step(F && f, const Eigen::MatrixBase<QDer> & Q, Scalar<G> t, Scalar<G> dt)
+  {
+    static constexpr int Nx = Dof<G>;
+
+    // linearize each filter
+    const auto f_x = [&f, &t]<typename _T>(const CastT<_T, G> & x) -> Tangent<CastT<_T, G>> { return f(t, x); };
+    for (auto i = 0; i < N; ++i) {
+      const auto [fv, dr] = diff::dr<1, DiffType>(f_x, wrt(g_[static_cast<std::size_t>(i)]));
+      const CovT A        = -ad<G>(fv) + dr;
+      for (auto c = 0; c < Nx; ++c) {
+        dg_(i, c) = fv(c);
+        for (auto r = 0; r < Nx; ++r) { A_(i, idx(r, c)) = A(r, c); }
+      }
+    }
+
+    // covariance derivative A P + P A' + Q (upper triangle)
+    for (auto c = 0; c < Nx; ++c) {
+      for (auto r = 0; r <= c; ++r) {
+        Lanes d = Lanes::Constant(Q(r, c));
+        for (auto k = 0; k < Nx; ++k) {
+          d += A_.col(idx(r, k)) * P_.col(idx(k, c)) + P_.col(idx(r, k)) * A_.col(idx(c, k));
+        }
+        dP_.col(idx(r, c)) = d;
+      }
+    }
+
+    for (auto c = 0; c < Nx; ++c) {
+      for (auto r = 0; r <= c; ++r) {
+        P_.col(idx(r, c)) += dt * dP_.col(idx(r, c));
+        if (r != c) { P_.col(idx(c, r)) = P_.col(idx(r, c)); }
+      }
+    }
+
+    for (auto i = 0; i < N; ++i) { g_[static_cast<std::size_t>(i)] += Tangent<G>(dt * dg_.row(i).transpose()); }
+  }
+
+  // filter estimates
+  std::array<G, N> g_;
+
+  // covariances and dynamics linearizations, column idx(r, c) holds coefficient (r, c) of all filters
+  Eigen::Array<Scalar<G>, N, -1> P_, A_, dP_;
+
+  // tangent increments, column k holds coefficient k of all filters
+  Eigen::Array<Scalar<G>, N, -1> dg_;
+
+  // update() workspace: residuals, measurement Jacobians, H P, Cholesky factors of S, and transposed Kalman gains
+  Eigen::Array<Scalar<G>, N, -1> r_, H_, HP_, L_, Kt_;
+};
+
+}  // namespace smooth::feedback
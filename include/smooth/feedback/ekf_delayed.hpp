@@ -0,0 +1,311 @@
+// Copyright (C) 2022 Petter Nilsson. MIT License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Extended Kalman filter with out-of-sequence measurements.
+ */
+
+#include <boost/numeric/odeint.hpp>
+#include <smooth/concepts/lie_group.hpp>
+#include <smooth/diff.hpp>
+
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ekf.hpp"
+
+namespace smooth::feedback {
+
+/**
+ * @brief Extended Kalman filter on Lie groups that accepts late (out-of-sequence) measurements.
+ *
+ * The filter keeps a fixed-capacity ring buffer of events (resets, input changes, predictions, and measurements)
+ * together with snapshots \f$ (t, \hat g, P, u) \f$ of the filter state just before each event. A measurement with a
+ * time stamp before the current filter time is inserted into the event log at the right place, after which the
+ * filter rewinds to the preceding snapshot and replays all later events.
+ *
+ * Since predict() calls are logged, a replay integrates over the same intervals as the original calls and gives the
+ * same result as in-order processing also when the ODE solver step size is not set.
+ *
+ * Memory is allocated at construction. Since at most capacity events are replayed the cost of a late
+ * measurement is bounded by capacity predictions and updates. Measurements older than the oldest event in the
+ * buffer are rejected.
+ *
+ * @tparam G \p smooth::LieGroup state type
+ * @tparam U \p smooth::Manifold input type
+ * @tparam Dyn dynamics type, callable as \f$ f(t, x, u) \f$ with \f$ t \in \mathbb{R} \f$, \f$ x \in \mathbb{G} \f$,
+ * and \f$ u \in \mathbb{U} \f$ that returns a tangent vector (see EKF::predict())
+ * @tparam Meas measurement model type, callable as \f$ h(x) \f$ (see EKF::update()). Every measurement stores its
+ * own instance of Meas, so different measurements can be modeled by lambdas with different captures.
+ * @tparam DiffType \p smooth::diff::Type method for calculating derivatives
+ * @tparam Stpr \p boost::numeric::odeint templated stepper type (see EKF)
+ */
+template<
+  LieGroup G,
+  Manifold U,
+  typename Dyn,
+  typename Meas,
+  diff::Type DiffType                 = diff::Type::Default,
+  template<typename...> typename Stpr = boost::numeric::odeint::euler>
+class DelayedEKF
+{
+public:
+  //! Covariance type.
+  using CovT = typename EKF<G, DiffType, Stpr>::CovT;
+
+  //! Measurement type.
+  using Y = std::decay_t<std::invoke_result_t<const Meas &, G>>;
+
+  //! Measurement covariance type.
+  using RT = Eigen::Matrix<Scalar<G>, Dof<Y>, Dof<Y>>;
+
+  /**
+   * @brief Create a filter.
+   *
+   * @param f dynamics
+   * @param Q process covariance (see EKF::predict())
+   * @param capacity maximal number of events in the history buffer (must be positive)
+   * @param dt maximal ODE solver step size
+   */
+  DelayedEKF(Dyn f, const CovT & Q, std::size_t capacity, std::optional<Scalar<G>> dt = {})
+      : f_(std::move(f)), Q_(Q), dt_(dt), buf_(capacity + 1)
+  {
+    assert(capacity > 0);
+  }
+
+  /**
+   * @brief Reset filter.
+   *
+   * Clears the event history.
+   *
+   * @param t time
+   * @param g filter value
+   * @param P filter covariance
+   * @param u input
+   */
+  void reset(Scalar<G> t, const G & g, const CovT & P, const U & u = Default<U>())
+  {
+    head_  = 0;
+    size_  = 0;
+    t_     = t;
+    t_now_ = t;
+    u_     = u;
+    ekf_.reset(g, P);
+
+    push_and_apply(Event{.t = t, .kind = Kind::Reset});
+  }
+
+  /**
+   * @brief Change the input at time t.
+   *
+   * The filter is propagated to time t with the previous input.
+   *
+   * @note t must not be earlier than the current filter time.
+   */
+  void set_input(Scalar<G> t, const U & u)
+  {
+    assert(t >= t_now_);
+    propagate(t);
+    t_now_ = t;
+    push_and_apply(Event{.t = t, .kind = Kind::Input, .u_new = u});
+  }
+
+  /**
+   * @brief Propagate filter to time t.
+   *
+   * The prediction is logged as an event in the history buffer.
+   *
+   * @note t must not be earlier than the current filter time.
+   */
+  void predict(Scalar<G> t)
+  {
+    assert(t >= t_now_);
+    if (t == t_now_) { return; }
+    propagate(t);
+    t_now_ = t;
+    push_and_apply(Event{.t = t, .kind = Kind::Predict});
+  }
+
+  /**
+   * @brief Add a measurement \f$ y = h(x(t)) + w \f$ where \f$ w \sim \mathcal N(0, R) \f$.
+   *
+   * If t is earlier than the current filter time the filter is rewound to the last event before t, and all
+   * subsequent events are replayed.
+   *
+   * @param t measurement time
+   * @param h measurement function
+   * @param y measurement value
+   * @param R measurement covariance
+   *
+   * @return false if the measurement is older than the oldest event in the history buffer and was ignored,
+   * true otherwise
+   */
+  bool update(Scalar<G> t, const Meas & h, const Y & y, const RT & R)
+  {
+    if (t < at(0).t) { return false; }
+
+    Event e{.t = t, .kind = Kind::Measurement, .y = y, .R = R};
+
+    if (t >= t_now_) {
+      // in-order measurement
+      propagate(t);
+      t_now_ = t;
+      e.h.emplace(h);
+      push_and_apply(std::move(e));
+      return true;
+    }
+
+    // insert after all events with time less than or equal to t
+    std::size_t pos = size_;
+    while (at(pos - 1).t > t) { --pos; }
+
+    for (auto i = size_; i > pos; --i) { copy_event(at(i), at(i - 1)); }
+    copy_event(at(pos), e);
+    at(pos).h.emplace(h);
+    ++size_;
+
+    // rewind to event before and replay
+    replay(pos - 1);
+
+    drop_oldest();
+    return true;
+  }
+
+  /// @brief Current filter time.
+  Scalar<G> time() const { return t_now_; }
+
+  /// @brief Access filter state estimate.
+  G estimate() const { return ekf_.estimate(); }
+
+  /// @brief Access filter covariance.
+  CovT covariance() const { return ekf_.covariance(); }
+
+  /// @brief Number of events in the history buffer.
+  std::size_t history_size() const { return size_; }
+
+private:
+  enum class Kind : std::uint8_t { Reset, Input, Predict, Measurement };
+
+  struct Event
+  {
+    // event time and type
+    Scalar<G> t{0};
+    Kind kind{Kind::Reset};
+
+    // filter snapshot before event
+    G g{Default<G>()};
+    CovT P{CovT::Zero()};
+    U u{Default<U>()};
+
+    // input event data
+    U u_new{Default<U>()};
+
+    // measurement event data
+    std::optional<Meas> h{};
+    Y y{Default<Y>()};
+    RT R{RT::Zero()};
+  };
+
+  /// @brief Event at logical index i (0 is oldest)
+  Event & at(std::size_t i) { return buf_[(head_ + i) % buf_.size()]; }
+
+  /// @brief Copy event (Meas is not necessarily assignable)
+  static void copy_event(Event & dst, const Event & src)
+  {
+    dst.t     = src.t;
+    dst.kind  = src.kind;
+    dst.g     = src.g;
+    dst.P     = src.P;
+    dst.u     = src.u;
+    dst.u_new = src.u_new;
+    dst.h.reset();
+    if (src.h.has_value()) { dst.h.emplace(src.h.value()); }
+    dst.y = src.y;
+    dst.R = src.R;
+  }
+
+  /// @brief Propagate filter from t_ to t1 with current input
+  void propagate(Scalar<G> t1)
+  {
+    if (t1 <= t_) { return; }
+    const Scalar<G> t0 = t_;
+    ekf_.predict([this, t0](Scalar<G> s, const auto & x) { return f_(t0 + s, x, u_); }, Q_, t1 - t0, dt_);
+    t_ = t1;
+  }
+
+  /// @brief Store snapshot in event and apply it to the filter (filter must be at event time)
+  void snapshot_and_apply(Event & e)
+  {
+    e.g = ekf_.estimate();
+    e.P = ekf_.covariance();
+    e.u = u_;
+
+    if (e.kind == Kind::Input) {
+      u_ = e.u_new;
+    } else if (e.kind == Kind::Measurement) {
+      ekf_.update(e.h.value(), e.y, e.R);
+    }
+  }
+
+  /// @brief Append event to history and apply it
+  void push_and_apply(Event && e)
+  {
+    Event & slot = at(size_);
+    copy_event(slot, e);
+    ++size_;
+    snapshot_and_apply(slot);
+    drop_oldest();
+  }
+
+  /// @brief Restore snapshot of event i0 and replay all events from i0, then propagate to current time
+  void replay(std::size_t i0)
+  {
+    const Event & e0 = at(i0);
+    ekf_.reset(e0.g, e0.P);
+    u_ = e0.u;
+    t_ = e0.t;
+
+    for (auto i = i0; i < size_; ++i) {
+      Event & e = at(i);
+      propagate(e.t);
+      snapshot_and_apply(e);
+    }
+
+    propagate(t_now_);
+  }
+
+  /// @brief Remove oldest event if buffer is over capacity
+  void drop_oldest()
+  {
+    if (size_ == buf_.size()) {
+      at(0).h.reset();
+      head_ = (head_ + 1) % buf_.size();
+      --size_;
+    }
+  }
+
+  Dyn f_;
+  CovT Q_;
+  std::optional<Scalar<G>> dt_;
+
+  // filter at time t_, and input
+  EKF<G, DiffType, Stpr> ekf_{};
+  Scalar<G> t_{0};
+  U u_{Default<U>()};
+
+  // time of latest call (time of last event)
+  Scalar<G> t_now_{0};
+
+  // ring buffer of events (one extra slot for insertion)
+  std::vector<Event> buf_;
+  std::size_t head_{0};
+  std::size_t size_{0};
+};
+
+}  // namespace smooth::feedback
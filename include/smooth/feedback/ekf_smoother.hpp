@@ -0,0 +1,221 @@
+// Copyright (C) 2022 Petter Nilsson. MIT License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Fixed-lag Rauch-Tung-Striebel smoother on Lie groups.
+ */
+
+#include <Eigen/Cholesky>
+#include <boost/numeric/odeint.hpp>
+#include <smooth/concepts/lie_group.hpp>
+#include <smooth/diff.hpp>
+
+#include <cassert>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ekf.hpp"
+
+namespace smooth::feedback {
+
+/**
+ * @brief Fixed-lag smoother on Lie groups.
+ *
+ * Runs an EKF forward in time and stores the filtered and predicted estimates of the last window states in a
+ * preallocated ring buffer. Every call to predict() adds a state to the window. The prediction uses
+ * EKF::predict_discrete(), and the transition matrix \f$ \Phi_k \f$ of the error dynamics \f$ e_{k+1} = \Phi_k e_k
+ * + w_k \f$ is used to compute the smoother gain
+ * \f[
+ *   C_k = P_{k|k} \Phi_k^T P_{k+1|k}^{-1}
+ * \f]
+ * when the state is added. A call to smooth() then runs the Rauch-Tung-Striebel backward pass over the window,
+ * \f[
+ *   \hat x_{k|n} = \hat x_{k|k} \oplus C_k (\hat x_{k+1|n} \ominus \hat x_{k+1|k}), \quad
+ *   P_{k|n} = P_{k|k} + C_k (P_{k+1|n} - P_{k+1|k}) C_k^T.
+ * \f]
+ *
+ * All memory is allocated at construction.
+ *
+ * @tparam G \p smooth::LieGroup state type
+ * @tparam DiffType \p smooth::diff::Type method for calculating derivatives
+ * @tparam Stpr \p boost::numeric::odeint templated stepper type (see EKF)
+ */
+template<
+  LieGroup G,
+  diff::Type DiffType                 = diff::Type::Default,
+  template<typename...> typename Stpr = boost::numeric::odeint::euler>
+class FixedLagSmoother
+{
+public:
+  //! Covariance type.
+  using CovT = typename EKF<G, DiffType, Stpr>::CovT;
+
+  /**
+   * @brief Create a smoother.
+   *
+   * @param window maximal number of states in the smoothing window (must be positive)
+   */
+  explicit FixedLagSmoother(std::size_t window) : buf_(window) { assert(window > 0); }
+
+  /**
+   * @brief Reset the smoother.
+   *
+   * Clears the window and adds a single state.
+   *
+   * @param g filter value
+   * @param P filter covariance
+   */
+  void reset(const G & g, const CovT & P)
+  {
+    ekf_.reset(g, P);
+    head_ = 0;
+    size_ = 1;
+
+    Slot & s = at(0);
+    s.g      = g;
+    s.P      = P;
+    s.g_pred = g;
+    s.P_pred = P;
+    s.C.setZero();
+    s.g_s = g;
+    s.P_s = P;
+  }
+
+  /**
+   * @brief Propagate the filter and add a state to the window.
+   *
+   * If the window is full the oldest state is dropped.
+   *
+   * @param f right-hand side of the dynamics (see EKF::predict_discrete())
+   * @param Q process covariance (see EKF::predict_discrete())
+   * @param tau amount of time to propagate
+   * @param dt maximal ODE solver step size for the state
+   */
+  template<typename F, typename QDer>
+  void predict(F && f, const Eigen::MatrixBase<QDer> & Q, Scalar<G> tau, std::optional<Scalar<G>> dt = {})
+  {
+    ekf_.predict_discrete(std::forward<F>(f), Q, tau, dt);
+
+    // smoother gain of current state
+    Slot & prev       = at(size_ - 1);
+    const CovT & Phi  = ekf_.transition();
+    const CovT P_pred = ekf_.covariance();
+    prev.C            = Eigen::LDLT<CovT>(P_pred).solve(Phi * prev.P).transpose();
+
+    if (size_ == buf_.size()) {
+      head_ = (head_ + 1) % buf_.size();
+    } else {
+      ++size_;
+    }
+
+    Slot & s = at(size_ - 1);
+    s.g_pred = ekf_.estimate();
+    s.P_pred = P_pred;
+    s.g      = s.g_pred;
+    s.P      = s.P_pred;
+    s.C.setZero();
+  }
+
+  /**
+   * @brief Update the newest state with a measurement \f$y = h(x) + w\f$ where \f$w \sim \mathcal N(0, R)\f$.
+   *
+   * @see EKF::update()
+   */
+  template<typename F, typename RDev, Manifold Y = std::invoke_result_t<F, G>>
+  void update(F && h, const Y & y, const Eigen::MatrixBase<RDev> & R)
+  {
+    ekf_.update(std::forward<F>(h), y, R);
+
+    Slot & s = at(size_ - 1);
+    s.g      = ekf_.estimate();
+    s.P      = ekf_.covariance();
+  }
+
+  /**
+   * @brief Run the backward smoothing pass over the window.
+   *
+   * Requires \f$ O(\mathrm{window} \cdot \dim \mathfrak{g}^3) \f$ operations and no allocations.
+   */
+  void smooth()
+  {
+    Slot & last = at(size_ - 1);
+    last.g_s    = last.g;
+    last.P_s    = last.P;
+
+    for (auto i = size_ - 1; i > 0; --i) {
+      const Slot & next = at(i);
+      Slot & s          = at(i - 1);
+
+      s.g_s = s.g + Tangent<G>(s.C * (next.g_s - next.g_pred));
+      s.P_s = s.P + s.C * (next.P_s - next.P_pred) * s.C.transpose();
+    }
+  }
+
+  /// @brief Number of states in the window.
+  std::size_t size() const { return size_; }
+
+  /// @brief Filtered estimate of the newest state.
+  G estimate() const { return ekf_.estimate(); }
+
+  /// @brief Filtered covariance of the newest state.
+  CovT covariance() const { return ekf_.covariance(); }
+
+  /**
+   * @brief Smoothed estimate of state i in the window (0 is the oldest).
+   *
+   * @note Valid after smooth().
+   */
+  const G & smoothed_estimate(std::size_t i) const
+  {
+    assert(i < size_);
+    return at(i).g_s;
+  }
+
+  /**
+   * @brief Smoothed covariance of state i in the window (0 is the oldest).
+   *
+   * @note Valid after smooth().
+   */
+  const CovT & smoothed_covariance(std::size_t i) const
+  {
+    assert(i < size_);
+    return at(i).P_s;
+  }
+
+private:
+  struct Slot
+  {
+    // filtered estimate
+    G g{Default<G>()};
+    CovT P{CovT::Identity()};
+
+    // predicted estimate (from previous state)
+    G g_pred{Default<G>()};
+    CovT P_pred{CovT::Identity()};
+
+    // smoother gain to next state
+    CovT C{CovT::Zero()};
+
+    // smoothed estimate
+    G g_s{Default<G>()};
+    CovT P_s{CovT::Identity()};
+  };
+
+  /// @brief Slot at logical index i (0 is oldest)
+  Slot & at(std::size_t i) { return buf_[(head_ + i) % buf_.size()]; }
+
+  /// @brief Slot at logical index i (0 is oldest)
+  const Slot & at(std::size_t i) const { return buf_[(head_ + i) % buf_.size()]; }
+
+  EKF<G, DiffType, Stpr> ekf_{};
+
+  std::vector<Slot> buf_;
+  std::size_t head_{0};
+  std::size_t size_{1};
+};
+
+}  // namespace smooth::feedback
@@ -0,0 +1,237 @@
+// Copyright (C) 2022 Petter Nilsson. MIT License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Extended Kalman filter with sparse Jacobians.
+ */
+
+#include <Eigen/Cholesky>
+#include <Eigen/Sparse>
+#include <boost/numeric/odeint.hpp>
+#include <smooth/compat/odeint.hpp>
+#include <smooth/concepts/lie_group.hpp>
+#include <smooth/diff.hpp>
+#include <smooth/lie_sparse.hpp>
+
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace smooth::feedback {
+
+/**
+ * @brief Extended Kalman filter on Lie groups that exploits sparsity in the dynamics and measurement Jacobians.
+ *
+ * Has the same interface and produces the same result as EKF, but the linearizations
+ * \f$ A = -\mathrm{ad}_{f} + \mathrm{d}^r f_x \f$ and \f$ H = \mathrm{d}^r h_x \f$ are used in sparse form.
+ * For states with many weakly coupled parts, e.g. a \p smooth::Bundle of a pose and landmark or bias states, the
+ * Jacobians are block-sparse and
+ * - the product \f$ A P + P A^T + Q \f$ in a covariance ODE evaluation requires
+ * \f$ O(\mathrm{nnz}(A) \dim \mathfrak{g}) \f$ operations, and
+ * - an update requires \f$ O(\mathrm{nnz}(H) \dim \mathfrak{g} + \dim \mathbb{Y} \dim \mathfrak{g}^2) \f$ operations,
+ *
+ * instead of \f$ O(\dim \mathfrak{g}^3) \f$. The Jacobians are still evaluated as dense matrices, and each covariance
+ * ODE evaluation scans \f$ \mathrm{d}^r f_x \f$ for new couplings, which adds \f$ O(\dim \mathfrak{g}^2) \f$
+ * operations on top of the cost of differentiating \f$ f \f$. The covariance itself is kept dense since it
+ * generally fills in as soon as parts are correlated by measurements.
+ *
+ * The sparsity pattern of \f$ A \f$ is kept in a pre-allocated sparse matrix whose values are updated in place. It
+ * starts out as the (block-diagonal) pattern of \f$ \mathrm{ad} \f$ of the Bundle parts and grows whenever
+ * \f$ \mathrm{d}^r f_x \f$ couples new entries, which only allocates memory the first time a coupling appears.
+ *
+ * @note Jacobians are evaluated with the method given by DiffType. Zeros that are structural in the Bundle part
+ * structure are exact also for numerical differentiation, and are left out of the sparse computations.
+ *
+ * @tparam G \p smooth::LieGroup type
+ * @tparam DiffType \p smooth::diff::Type method for calculating derivatives
+ * @tparam Stpr \p boost::numeric::odeint templated stepper type (see EKF)
+ */
+template<
+  LieGroup G,
+  diff::Type DiffType                 = diff::Type::Default,
+  template<typename...> typename Stpr = boost::numeric::odeint::euler>
+  requires(Dof<G> > 0)
+class SparseEKF
+{
+public:
+  //! Covariance type.
+  using CovT = Eigen::Matrix<Scalar<G>, Dof<G>, Dof<G>>;
+
+  /**
+   * @brief Create a filter.
+   *
+   * Allocates the sparse dynamics Jacobian with the pattern of the adjoint.
+   */
+  SparseEKF()
+  {
+    pattern_.setConstant(false);
+    for (auto i = 0; i < ad_.outerSize(); ++i) {
+      for (typename decltype(ad_)::InnerIterator it(ad_, i); it; ++it) { pattern_(it.row(), it.col()) = true; }
+    }
+    allocate_dynamics();
+  }
+
+  /**
+   * @brief Reset the state of the EKF.
+   *
+   * @param g filter value
+   * @param P filter covariance
+   */
+  void reset(const G & g, const CovT & P)
+  {
+    g_hat_ = g;
+    P_     = P;
+  }
+
+  /**
+   * @brief Access filter state estimate.
+   */
+  G estimate() const { return g_hat_; }
+
+  /**
+   * @brief Access filter covariance.
+   */
+  CovT covariance() const { return P_; }
+
+  /**
+   * @brief Number of entries in the sparsity pattern of the dynamics Jacobian.
+   */
+  Eigen::Index nnz_dynamics() const { return A_.nonZeros(); }
+
+  /**
+   * @brief Propagate EKF through dynamics \f$ \mathrm{d}^r x_t = f(t, x) \f$ with covariance
+   * \f$Q\f$ over a time interval \f$ [0, \tau] \f$.
+   *
+   * @see EKF::predict()
+   */
+  template<typename F, typename QDer>
+  void predict(F && f, const Eigen::MatrixBase<QDer> & Q, Scalar<G> tau, std::optional<Scalar<G>> dt = {})
+  {
+    const auto state_ode = [&f](const G & g, Tangent<G> & dg, Scalar<G> t) { dg = f(t, g); };
+
+    // only upper triangular part of Q is used
+    Q_ = Q.template selfadjointView<Eigen::Upper>();
+
+    const auto cov_ode = [this, &f](const CovT & cov, CovT & dcov, Scalar<G> t) {
+      const auto f_x      = [&f, &t]<typename _T>(const CastT<_T, G> & x) -> Tangent<CastT<_T, G>> { return f(t, x); };
+      const auto [fv, dr] = diff::dr<1, DiffType>(f_x, wrt(g_hat_));
+      update_dynamics(fv, dr);
+      AP_.noalias() = A_ * cov;
+      dcov          = AP_ + AP_.transpose() + Q_;
+    };
+
+    Scalar<G> t          = 0;
+    const Scalar<G> dt_v = dt.value_or(2 * tau);
+    while (t + dt_v < tau) {
+      // step covariance first since it depends on g_hat_
+      cst_.do_step(cov_ode, P_, t, dt_v);
+      sst_.do_step(state_ode, g_hat_, t, dt_v);
+      t += dt_v;
+    }
+
+    // last step up to time t
+    cst_.do_step(cov_ode, P_, t, tau - t);
+    sst_.do_step(state_ode, g_hat_, t, tau - t);
+  }
+
+  /**
+   * @brief Update EKF with a measurement \f$y = h(x) + w\f$ where \f$w \sim \mathcal N(0, R)\f$.
+   *
+   * @see EKF::update()
+   */
+  template<typename F, typename RDev, Manifold Y = std::invoke_result_t<F, G>>
+  void update(F && h, const Y & y, const Eigen::MatrixBase<RDev> & R)
+  {
+    const auto [hval, H] = diff::dr<1, DiffType>(h, wrt(g_hat_));
+
+    using Result = std::decay_t<decltype(hval)>;
+
+    static_assert(Manifold<Result>, "h(x) is not a Manifold");
+
+    static constexpr Eigen::Index Ny = Dof<Result>;
+
+    static_assert(Ny > 0, "h(x) must be statically sized");
+
+    // H P and innovation covariance S = H P H' + R, skipping zeros in H
+    Eigen::Matrix<Scalar<G>, Ny, Dof<G>> HP = Eigen::Matrix<Scalar<G>, Ny, Dof<G>>::Zero();
+    Eigen::Matrix<Scalar<G>, Ny, Ny> S      = R.template selfadjointView<Eigen::Upper>().toDenseMatrix();
+    for (auto c = 0; c < Dof<G>; ++c) {
+      for (auto r = 0; r < Ny; ++r) {
+        if (H(r, c) != 0) { HP.row(r) += H(r, c) * P_.row(c); }
+      }
+    }
+    for (auto c = 0; c < Dof<G>; ++c) {
+      for (auto r = 0; r < Ny; ++r) {
+        if (H(r, c) != 0) { S.col(r) += H(r, c) * HP.col(c); }
+      }
+    }
+
+    // solve for transposed Kalman gain K' = S^{-1} H P
+    const Eigen::Matrix<Scalar<G>, Ny, Dof<G>> Kt = S.ldlt().solve(HP);
+
+    g_hat_ += Kt.transpose() * (y - hval);
+    P_ = (P_ - Kt.transpose() * HP).template selfadjointView<Eigen::Upper>();
+  }
+
+private:
+  /// @brief Allocate A_ with the entries in pattern_
+  void allocate_dynamics()
+  {
+    std::vector<Eigen::Triplet<Scalar<G>>> triplets;
+    for (auto c = 0; c < Dof<G>; ++c) {
+      for (auto r = 0; r < Dof<G>; ++r) {
+        if (pattern_(r, c)) { triplets.emplace_back(r, c, 0); }
+      }
+    }
+    A_.resize(Dof<G>, Dof<G>);
+    A_.setFromTriplets(triplets.begin(), triplets.end());
+    A_.makeCompressed();
+  }
+
+  /// @brief Write A = -ad_f + dr into A_ (grows the pattern if dr has entries outside of it)
+  void update_dynamics(const Tangent<G> & fv, const TangentMap<G> & dr)
+  {
+    bool grow = false;
+    for (auto c = 0; c < Dof<G>; ++c) {
+      for (auto r = 0; r < Dof<G>; ++r) {
+        if (dr(r, c) != 0 && !pattern_(r, c)) {
+          pattern_(r, c) = true;
+          grow           = true;
+        }
+      }
+    }
+    if (grow) { allocate_dynamics(); }
+
+    for (auto c = 0; c < A_.outerSize(); ++c) {
+      for (typename decltype(A_)::InnerIterator it(A_, c); it; ++it) { it.valueRef() = dr(it.row(), it.col()); }
+    }
+
+    ad_sparse<G>(ad_, fv);
+    for (auto c = 0; c < ad_.outerSize(); ++c) {
+      for (typename decltype(ad_)::InnerIterator it(ad_, c); it; ++it) {
+        A_.coeffRef(it.row(), it.col()) -= it.value();
+      }
+    }
+  }
+
+  // filter estimate and covariance
+  G g_hat_ = Default<G>();
+  CovT P_  = CovT::Identity();
+
+  // sparse adjoint, sparse dynamics linearization and its pattern, and product buffer
+  Eigen::SparseMatrix<Scalar<G>> ad_ = ad_sparse_pattern<G>;
+  Eigen::SparseMatrix<Scalar<G>> A_;
+  Eigen::Matrix<bool, Dof<G>, Dof<G>> pattern_;
+  CovT AP_{CovT::Zero()};
+
+  // process covariance of current predict() call
+  CovT Q_{CovT::Zero()};
+
+  // steppers for numerical ODE solutions
+  Stpr<G, Scalar<G>, Tangent<G>, Scalar<G>, boost::numeric::odeint::vector_space_algebra> sst_{};
+  Stpr<CovT, Scalar<G>, CovT, Scalar<G>, boost::numeric::odeint::vector_space_algebra> cst_{};
+};
+
+}  // namespace smooth::feedback
@@ -320,6 +320,9 @@ struct MPCParams
    *
    * @note The actual number of points is ceil(K / Kmesh) where Kmesh is a template parameter of
    * MPC.
+   *
+   * @note Ignored if the number of mesh intervals is fixed at compile time via the NIvals template
+   * parameter of MPC.
    */
   std::size_t K{10};
 
@@ -377,6 +380,8 @@ struct MPCWeights
  * @tparam CR callable type that represents running constraints
  * @tparam DT differentiation method
  * @tparam Kmesh number of collocation points per mesh interval
+ * @tparam NIvals number of mesh intervals, or 0 to determine it from MPCParams::K at runtime. When
+ * non-zero a FixedMesh with compile-time nodes and matrices is used.
  *
  * This MPC class keeps and repeatedly solves an internal OCP that is updated to track a
  * time-dependent trajectory defined via set_xdes() and set_udes().
@@ -387,8 +392,9 @@ template<
   Manifold U,
   typename F,
   typename CR,
-  std::size_t Kmesh = 4,
-  diff::Type DT     = diff::Type::Default>
+  std::size_t Kmesh  = 4,
+  diff::Type DT      = diff::Type::Default,
+  std::size_t NIvals = 0>
 class MPC
 {
 
@@ -420,7 +426,13 @@ public:
   inline MPC(
     F && f, CR && cr, Eigen::Vector<double, Ncr> && crl, Eigen::Vector<double, Ncr> && cru, MPCParams && prm = {}, MPCWeights<X, U> && wts = {})
       : xdes_{std::make_shared<detail::XDes<T, X>>()}, udes_{std::make_shared<detail::UDes<T, U>>()},
-        mesh_{(prm.K + Kmesh - 1) / Kmesh},
+        mesh_{[&prm]() {
+          if constexpr (NIvals == 0) {
+            return MeshT{(prm.K + Kmesh - 1) / Kmesh};
+          } else {
+            return MeshT{};
+          }
+        }()},
         ocp_{
           .theta = {.Qtf = wts.Qtf},
           .f     = {.f = std::forward<F>(f)},
@@ -640,7 +652,8 @@ private:
   std::shared_ptr<detail::UDes<T, U>> udes_;
 
   // collocation mesh
-  Mesh<Kmesh, Kmesh> mesh_{};
+  using MeshT = std::conditional_t<NIvals == 0, Mesh<Kmesh, Kmesh>, FixedMesh<Kmesh, NIvals>>;
+  MeshT mesh_{};
 
   // internal optimal control problem
   OCP<
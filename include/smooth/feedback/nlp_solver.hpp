@@ -0,0 +1,491 @@
+// Copyright (C) 2022 Petter Nilsson. MIT License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Augmented Lagrangian solver for nonlinear programs.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <optional>
+
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+
+#include "nlp.hpp"
+
+namespace smooth::feedback {
+
+/**
+ * @brief Options for NLPSolver
+ */
+struct NLPSolverParams
+{
+  /// print solver info to stdout
+  bool verbose = false;
+
+  /// threshold for fixed-point residual of inner problem
+  double eps_abs = 1e-6;
+  /// threshold for constraint violation
+  double delta_abs = 1e-6;
+
+  /// inner threshold in first outer iteration
+  double eps_init = 1e-2;
+  /// inner threshold decrease between outer iterations
+  double eps_factor = 0.1;
+
+  /// initial constraint penalty
+  double rho_init = 10;
+  /// penalty increase for constraints whose violation does not decrease sufficiently
+  double rho_factor = 10;
+  /// maximal constraint penalty
+  double rho_max = 1e9;
+  /// required violation decrease factor to keep penalty
+  double theta = 0.25;
+  /// bound on multiplier magnitude
+  double y_max = 1e12;
+
+  /// number of L-BFGS pairs
+  std::size_t lbfgs_mem = 10;
+  /// step size safety factor (step size is alpha / L)
+  double alpha = 0.95;
+  /// line search sufficient decrease parameter
+  double beta = 0.5;
+  /// max number of line search halvings before taking a forward-backward step
+  std::size_t ls_iter = 10;
+
+  /// max number of outer iterations
+  std::size_t max_outer_iter = 100;
+  /// max total number of inner iterations (default no limit)
+  std::optional<std::size_t> max_iter = {};
+  /// max solution time (default no limit)
+  std::optional<std::chrono::nanoseconds> max_time = {};
+};
+
+/**
+ * @brief Solver for nonlinear programs
+ *
+ * Constraints \f$ g_l \leq g(x) \leq g_u \f$ are handled by an augmented Lagrangian outer loop, and the inner bound
+ * constrained problems \f$ \min_{x_l \leq x \leq x_u} \psi(x) \f$ are solved with PANOC, i.e. projected gradient steps
+ * accelerated by L-BFGS directions and a line search on the forward-backward envelope.
+ *
+ * Only first-order information (NLP::df_dx() and NLP::dg_dx()) is required.
+ *
+ * Use this class to efficiently solve many NLPs of the same size. For one-off NLPs, see solve_nlp().
+ *
+ * This is a third-party implementation of the algorithms described in the following papers:
+ * * Stella, L., Themelis, A., Sopasakis, P., Patrinos, P.
+ * **A simple and efficient algorithm for nonlinear model predictive control.**
+ * *IEEE 56th Conference on Decision and Control* (2017).
+ * * Sopasakis, P., Fresk, E., Patrinos, P.
+ * **OpEn: Code Generation for Embedded Nonconvex Optimization.**
+ * *IFAC-PapersOnLine* 53(2) (2020).
+ */
+class NLPSolver
+{
+  static inline const double inf = std::numeric_limits<double>::infinity();
+
+public:
+  /**
+   * @brief Default constructor.
+   */
+  NLPSolver(const NLPSolverParams & prm = {}) : prm_(prm) {}
+
+  /**
+   * @brief Construct and allocate working memory.
+   *
+   * @param n number of variables
+   * @param m number of constraints
+   * @param prm solver options
+   */
+  NLPSolver(std::size_t n, std::size_t m, const NLPSolverParams & prm = {}) : prm_(prm) { analyze(n, m); }
+
+  /// @brief Default copy constructor
+  NLPSolver(const NLPSolver &) = default;
+  /// @brief Default move constructor
+  NLPSolver(NLPSolver &&) noexcept = default;
+  /// @brief Default copy assignment
+  NLPSolver & operator=(const NLPSolver &) = default;
+  /// @brief Default move assignment
+  NLPSolver & operator=(NLPSolver &&) noexcept = default;
+  /// @brief Default destructor
+  ~NLPSolver() = default;
+
+  /**
+   * @brief Access most recent NLP solution.
+   */
+  const NLPSolution & sol() const { return sol_; }
+
+  /**
+   * @brief Allocate working memory for problems with n variables and m constraints.
+   */
+  void analyze(std::size_t n, std::size_t m)
+  {
+    const Eigen::Index N = static_cast<Eigen::Index>(n), M = static_cast<Eigen::Index>(m);
+    const Eigen::Index L = static_cast<Eigen::Index>(prm_.lbfgs_mem);
+
+    sol_.x.setZero(N);
+    sol_.zl.setZero(N);
+    sol_.zu.setZero(N);
+    sol_.lambda.setZero(M);
+
+    xl_.resize(N);
+    xu_.resize(N);
+    x_.resize(N);
+    dfx_.resize(N);
+    xh_.resize(N);
+    dfxh_.resize(N);
+    xn_.resize(N);
+    dfxn_.resize(N);
+    xhn_.resize(N);
+    r_.resize(N);
+    rn_.resize(N);
+    d_.resize(N);
+
+    gl_.resize(M);
+    gu_.resize(M);
+    y_.resize(M);
+    sigma_.resize(M);
+    e_.resize(M);
+    v_.resize(M);
+    v_prev_.resize(M);
+
+    S_.resize(N, L);
+    Y_.resize(N, L);
+    rho_lbfgs_.resize(L);
+    a_lbfgs_.resize(L);
+  }
+
+  /**
+   * @brief Solve nonlinear program.
+   *
+   * @param nlp problem to solve
+   * @param warmstart initial guess for variables and constraint multipliers
+   */
+  const NLPSolution & solve(NLP auto & nlp, std::optional<std::reference_wrapper<const NLPSolution>> warmstart = {})
+  {
+    const auto n = static_cast<Eigen::Index>(nlp.n());
+    const auto m = static_cast<Eigen::Index>(nlp.m());
+
+    if (x_.size() != n || y_.size() != m) { analyze(nlp.n(), nlp.m()); }
+
+    t0_     = std::chrono::high_resolution_clock::now();
+    iter_   = 0;
+    n_lbfgs_ = 0;
+
+    xl_ = nlp.xl();
+    xu_ = nlp.xu();
+    gl_ = nlp.gl();
+    gu_ = nlp.gu();
+
+    if (warmstart.has_value()) {
+      x_ = warmstart.value().get().x.cwiseMax(xl_).cwiseMin(xu_);
+      if (warmstart.value().get().lambda.size() == m) {
+        y_ = warmstart.value().get().lambda.cwiseMax(-prm_.y_max).cwiseMin(prm_.y_max);
+      } else {
+        y_.setZero();
+      }
+    } else {
+      x_ = Eigen::VectorXd::Zero(n).cwiseMax(xl_).cwiseMin(xu_);
+      y_.setZero();
+    }
+
+    sigma_.setConstant(prm_.rho_init);
+    v_prev_.setConstant(inf);
+
+    // initial step size from Lipschitz estimate
+    psi_ = eval_psi(nlp, x_, dfx_);
+    xn_  = x_ + (1e-6 * x_.cwiseAbs()).cwiseMax(1e-6);
+    eval_psi(nlp, xn_, dfxn_);
+    const double Lest = (dfxn_ - dfx_).norm() / std::max((xn_ - x_).norm(), 1e-12);
+    gamma_            = prm_.alpha / std::clamp(Lest, 1e-6, 1e12);
+
+    if (prm_.verbose) {
+      using std::cout, std::setw, std::right;
+      // clang-format off
+      cout << "======================== NLP Solver =========================" << '\n';
+      cout << "Solving NLP with n=" << n << ", m=" << m << '\n';
+      cout << setw(8)  << right << "OUTER"
+           << setw(8)  << right << "INNER"
+           << setw(14) << right << "OBJ"
+           << setw(14) << right << "FP_RES"
+           << setw(14) << right << "CON_VIOL"
+           << setw(10) << right << "TIME" << '\n';
+      // clang-format on
+    }
+
+    std::optional<NLPSolution::Status> status;
+    double eps = std::max(prm_.eps_init, prm_.eps_abs);
+
+    for (auto outer = 0u; outer < prm_.max_outer_iter && !status.has_value(); ++outer) {
+      // minimize augmented Lagrangian for fixed multipliers
+      const auto [inner_status, fp_res] = inner(nlp, eps);
+
+      // multiplier update
+      psi_ = eval_psi(nlp, x_, dfx_);
+      v_   = y_;  // old multipliers
+      y_   = sigma_.cwiseProduct(e_).cwiseMax(-prm_.y_max).cwiseMin(prm_.y_max);
+      v_   = (y_ - v_).cwiseQuotient(sigma_);  // v = g(x) - proj(g(x) + y_old / sigma)
+
+      const double delta = m > 0 ? v_.lpNorm<Eigen::Infinity>() : 0.;
+
+      if (prm_.verbose) {
+        using std::cout, std::setw, std::right, std::chrono::microseconds;
+        cout << setw(8) << right << outer << setw(8) << right << iter_ << setw(14) << right << nlp.f(x_) << setw(14)
+             << right << fp_res << setw(14) << right << delta << setw(10) << right
+             << duration_cast<microseconds>(std::chrono::high_resolution_clock::now() - t0_).count() << '\n';
+      }
+
+      if (inner_status.has_value()) {
+        status = inner_status;
+      } else if (eps <= prm_.eps_abs && delta <= prm_.delta_abs) {
+        status = NLPSolution::Status::Optimal;
+      } else {
+        // increase penalty for constraints that did not improve enough
+        for (Eigen::Index i = 0; i < m; ++i) {
+          if (std::fabs(v_(i)) > prm_.delta_abs && std::fabs(v_(i)) > prm_.theta * std::fabs(v_prev_(i))) {
+            sigma_(i) = std::min(prm_.rho_factor * sigma_(i), prm_.rho_max);
+          }
+        }
+        v_prev_ = v_;
+        eps     = std::max(prm_.eps_factor * eps, prm_.eps_abs);
+      }
+    }
+
+    // bound multipliers from gradient of Lagrangian: df + dg' * lambda - zl + zu = 0
+    dfxn_ = nlp.df_dx(x_).transpose();
+    if (m > 0) { dfxn_ += nlp.dg_dx(x_).transpose() * y_; }
+
+    sol_.status    = status.value_or(NLPSolution::Status::MaxIterations);
+    sol_.iter      = iter_;
+    sol_.x         = x_;
+    sol_.zl        = dfxn_.cwiseMax(0);
+    sol_.zu        = (-dfxn_).cwiseMax(0);
+    sol_.lambda    = y_;
+    sol_.objective = nlp.f(x_);
+
+    if (prm_.verbose) {
+      using std::cout, std::chrono::microseconds;
+      cout << "NLP solver summary:" << '\n';
+      cout << "Result " << static_cast<int>(sol_.status) << '\n';
+      cout << "Total time (µs) "
+           << duration_cast<microseconds>(std::chrono::high_resolution_clock::now() - t0_).count() << '\n';
+      cout << "=============================================================" << '\n';
+    }
+
+    return sol_;
+  }
+
+protected:
+  /**
+   * @brief Evaluate augmented Lagrangian and its gradient.
+   *
+   * \f[
+   *   \psi(x) = f(x) + \frac{1}{2} \sum_i \sigma_i \mathrm{dist}^2_{[g_l, g_u]}(g_i(x) + y_i / \sigma_i).
+   * \f]
+   *
+   * Also sets e_ to \f$ z - \Pi(z) \f$ where \f$ z = g(x) + y / \sigma \f$.
+   */
+  double eval_psi(NLP auto & nlp, const Eigen::VectorXd & x, Eigen::VectorXd & grad)
+  {
+    double ret = nlp.f(x);
+    grad       = nlp.df_dx(x).transpose();
+
+    if (y_.size() > 0) {
+      e_ = nlp.g(x) + y_.cwiseQuotient(sigma_);
+      e_ -= e_.cwiseMax(gl_).cwiseMin(gu_);
+      ret += 0.5 * e_.dot(sigma_.cwiseProduct(e_));
+      grad += nlp.dg_dx(x).transpose() * sigma_.cwiseProduct(e_);
+    }
+
+    return ret;
+  }
+
+  /**
+   * @brief Forward-backward step: xh = proj(x - gamma * dfx), r = x - xh.
+   */
+  void fb_step(const Eigen::VectorXd & x, const Eigen::VectorXd & dfx, Eigen::VectorXd & xh, Eigen::VectorXd & r)
+  {
+    xh = (x - gamma_ * dfx).cwiseMax(xl_).cwiseMin(xu_);
+    r  = x - xh;
+  }
+
+  /**
+   * @brief Forward-backward envelope given function value, gradient, and residual.
+   */
+  double fbe(double psi, const Eigen::VectorXd & dfx, const Eigen::VectorXd & r) const
+  {
+    return psi - dfx.dot(r) + r.squaredNorm() / (2 * gamma_);
+  }
+
+  /**
+   * @brief Set d_ to L-BFGS direction -H r_ via the two-loop recursion.
+   */
+  void lbfgs_direction()
+  {
+    const auto L = static_cast<std::size_t>(S_.cols());
+
+    d_ = r_;
+    for (auto k = 0u; k < n_lbfgs_; ++k) {
+      const auto i = (head_lbfgs_ + L - 1 - k) % L;  // newest to oldest
+      a_lbfgs_(i)  = rho_lbfgs_(i) * S_.col(i).dot(d_);
+      d_ -= a_lbfgs_(i) * Y_.col(i);
+    }
+    if (n_lbfgs_ > 0) {
+      const auto i = (head_lbfgs_ + L - 1) % L;
+      d_ *= S_.col(i).dot(Y_.col(i)) / Y_.col(i).squaredNorm();
+    }
+    for (auto k = 0u; k < n_lbfgs_; ++k) {
+      const auto i   = (head_lbfgs_ + L - n_lbfgs_ + k) % L;  // oldest to newest
+      const double b = rho_lbfgs_(i) * Y_.col(i).dot(d_);
+      d_ += (a_lbfgs_(i) - b) * S_.col(i);
+    }
+    d_ = -d_;
+  }
+
+  /**
+   * @brief Add L-BFGS pair (s, y) = (xn_ - x_, rn_ - r_) if curvature condition holds.
+   */
+  void lbfgs_update()
+  {
+    const auto L = static_cast<std::size_t>(S_.cols());
+    if (L == 0) { return; }
+
+    S_.col(head_lbfgs_) = xn_ - x_;
+    Y_.col(head_lbfgs_) = rn_ - r_;
+
+    const double sy = S_.col(head_lbfgs_).dot(Y_.col(head_lbfgs_));
+    if (sy > 1e-12 * S_.col(head_lbfgs_).squaredNorm()) {
+      rho_lbfgs_(head_lbfgs_) = 1. / sy;
+      head_lbfgs_             = (head_lbfgs_ + 1) % L;
+      n_lbfgs_                = std::min(n_lbfgs_ + 1, L);
+    }
+  }
+
+  /**
+   * @brief Check iteration and time limits.
+   */
+  std::optional<NLPSolution::Status> check_limits() const
+  {
+    if (prm_.max_iter && iter_ >= prm_.max_iter.value()) { return NLPSolution::Status::MaxIterations; }
+    if (prm_.max_time && std::chrono::high_resolution_clock::now() > t0_ + prm_.max_time.value()) {
+      return NLPSolution::Status::MaxTime;
+    }
+    return std::nullopt;
+  }
+
+  /**
+   * @brief Minimize augmented Lagrangian over variable bounds with PANOC.
+   *
+   * @param nlp problem
+   * @param eps threshold on fixed-point residual \f$ \| x - \hat x \|_\infty / \gamma \f$
+   *
+   * @return pair of (status if a limit was hit, final fixed-point residual)
+   */
+  std::pair<std::optional<NLPSolution::Status>, double> inner(NLP auto & nlp, double eps)
+  {
+    n_lbfgs_    = 0;
+    head_lbfgs_ = 0;
+
+    psi_ = eval_psi(nlp, x_, dfx_);
+    fb_step(x_, dfx_, xh_, r_);
+
+    for (;;) {
+      // backtrack on Lipschitz estimate until quadratic upper bound holds at xh_
+      double psi_h = eval_psi(nlp, xh_, dfxh_);
+      while (psi_h > psi_ - dfx_.dot(r_) + (0.5 * prm_.alpha / gamma_) * r_.squaredNorm() + 1e-12 * std::fabs(psi_)) {
+        gamma_ *= 0.5;
+        n_lbfgs_ = 0;
+        fb_step(x_, dfx_, xh_, r_);
+        psi_h = eval_psi(nlp, xh_, dfxh_);
+      }
+
+      const double fp_res = r_.size() > 0 ? r_.lpNorm<Eigen::Infinity>() / gamma_ : 0.;
+      if (fp_res <= eps) { return {std::nullopt, fp_res}; }
+
+      ++iter_;
+      if (const auto lim = check_limits(); lim.has_value()) { return {lim, fp_res}; }
+
+      lbfgs_direction();
+
+      const double phi   = fbe(psi_, dfx_, r_);
+      const double sigma = prm_.beta * (1. - prm_.alpha) / (2 * gamma_);
+
+      double psi_n = 0;
+      double tau   = 1;
+      for (auto ls = 0u; ls <= prm_.ls_iter; ++ls) {
+        if (ls == prm_.ls_iter) {
+          // fall back to forward-backward step which ensures sufficient decrease
+          xn_   = xh_;
+          dfxn_ = dfxh_;
+          psi_n = psi_h;
+          fb_step(xn_, dfxn_, xhn_, rn_);
+          break;
+        }
+        xn_   = x_ - (1. - tau) * r_ + tau * d_;
+        psi_n = eval_psi(nlp, xn_, dfxn_);
+        fb_step(xn_, dfxn_, xhn_, rn_);
+        if (fbe(psi_n, dfxn_, rn_) <= phi - sigma * r_.squaredNorm()) { break; }
+        tau *= 0.5;
+      }
+
+      lbfgs_update();
+
+      x_.swap(xn_);
+      xh_.swap(xhn_);
+      dfx_.swap(dfxn_);
+      r_.swap(rn_);
+      psi_ = psi_n;
+    }
+  }
+
+private:
+  // solver parameters
+  NLPSolverParams prm_{};
+
+  // solution
+  NLPSolution sol_{};
+
+  // solver state
+  std::chrono::high_resolution_clock::time_point t0_{};
+  std::size_t iter_{0};
+  double gamma_{1}, psi_{0};
+
+  // bounds
+  Eigen::VectorXd xl_{}, xu_{}, gl_{}, gu_{};
+
+  // inner working memory
+  Eigen::VectorXd x_{}, dfx_{}, xh_{}, dfxh_{}, xn_{}, dfxn_{}, xhn_{}, r_{}, rn_{}, d_{};
+
+  // outer working memory
+  Eigen::VectorXd y_{}, sigma_{}, e_{}, v_{}, v_prev_{};
+
+  // L-BFGS memory
+  Eigen::MatrixXd S_{}, Y_{};
+  Eigen::VectorXd rho_lbfgs_{}, a_lbfgs_{};
+  std::size_t n_lbfgs_{0}, head_lbfgs_{0};
+};
+
+/**
+ * @brief Solve a nonlinear program using an augmented Lagrangian method.
+ *
+ * @param nlp problem to solve
+ * @param prm solver options
+ * @param warmstart initial guess for variables and constraint multipliers
+ *
+ * @see NLPSolver
+ */
+inline NLPSolution solve_nlp(
+  NLP auto && nlp, const NLPSolverParams & prm = {}, std::optional<std::reference_wrapper<const NLPSolution>> warmstart = {})
+{
+  NLPSolver solver(nlp.n(), nlp.m(), prm);
+  return solver.solve(nlp, warmstart);
+}
+
+}  // namespace smooth::feedback
@@ -135,6 +135,8 @@ struct OCPSolution
 
   ///@{
   /// @brief Callable functions for state and input
+  ///
+  /// Solutions created by this library evaluate efficiently for monotone times, but are not thread safe.
   std::function<U(double)> u;
   std::function<X(double)> x;
   //}@
@@ -8,7 +8,6 @@
  * tangent space around a reference trajectory.
  *
  * @todo More efficient implementation of Hessian in FlatDyn.
- * @todo Accept dxl as a template argument to avoid double differentiation.
  */
 
 #include <Eigen/Core>
@@ -16,6 +15,15 @@
 #include <smooth/bundle.hpp>
 #include <smooth/diff.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "collocation/mesh.hpp"
 #include "ocp.hpp"
 #include "smooth/lie_sparse.hpp"
 #include "utils/sparse.hpp"
@@ -80,13 +88,111 @@ inline Eigen::SparseMatrix<double> d_ad = []() -> Eigen::SparseMatrix<double> {
   return ret;
 }();
 
+/**
+ * @brief Linearization trajectory (xl, ul) and its first time derivatives.
+ *
+ * A single instance is shared between all functors of a flattened OCP. Values can be precomputed at a set of
+ * times (e.g. the collocation nodes of a mesh), evaluations at those times are then table lookups. The table is
+ * not modified after construction, so it can be read concurrently.
+ */
+template<LieGroup X, Manifold U, typename Xl, typename Ul>
+class FlatReference
+{
+public:
+  /// @brief Linearization trajectory values at a time t
+  struct Value
+  {
+    /// @brief xl(t)
+    X xl;
+    /// @brief d/dt xl(t)
+    Tangent<X> dxl;
+    /// @brief ul(t)
+    U ul;
+    /// @brief d/dt ul(t)
+    Tangent<U> dul;
+  };
+
+  /// @brief State linearization trajectory
+  Xl xl;
+  /// @brief Input linearization trajectory
+  Ul ul;
+
+  template<typename A1, typename A2>
+  FlatReference(A1 && a1, A2 && a2) : xl(std::forward<A1>(a1)), ul(std::forward<A2>(a2))
+  {}
+
+  /**
+   * @brief Create reference with values precomputed at times ts.
+   *
+   * @note Precomputed values are not updated if xl or ul are references whose targets change.
+   */
+  template<typename A1, typename A2>
+  FlatReference(A1 && a1, A2 && a2, std::vector<double> ts)
+      : xl(std::forward<A1>(a1)), ul(std::forward<A2>(a2)), ts_(std::move(ts))
+  {
+    std::sort(ts_.begin(), ts_.end());
+    ts_.erase(std::unique(ts_.begin(), ts_.end()), ts_.end());
+    vals_.reserve(ts_.size());
+    for (const double t : ts_) { vals_.push_back(evaluate(t)); }
+  }
+
+  /// @brief Precomputed values at time t, or nullptr if t is not in the table
+  const Value * find(const double t) const
+  {
+    const auto it = std::lower_bound(ts_.begin(), ts_.end(), t);
+    if (it == ts_.end() || *it != t) { return nullptr; }
+    return &vals_[static_cast<std::size_t>(std::distance(ts_.begin(), it))];
+  }
+
+  /// @brief Evaluate linearization trajectory and its derivatives at time t
+  Value operator()(const double t) const
+  {
+    if (const auto * val = find(t)) { return *val; }
+    return evaluate(t);
+  }
+
+  /// @brief Evaluate time derivative of xl at time t
+  Tangent<X> dxl(const double t) const
+  {
+    if (const auto * val = find(t)) { return val->dxl; }
+    const auto [unused, dxlval] = diff::dr<1>(xl, wrt(t));
+    return dxlval;
+  }
+
+private:
+  Value evaluate(const double t) const
+  {
+    const auto [xlval, dxlval] = diff::dr<1>(xl, wrt(t));
+    const auto [ulval, dulval] = diff::dr<1>(ul, wrt(t));
+    return Value{.xl = xlval, .dxl = dxlval, .ul = ulval, .dul = dulval};
+  }
+
+  std::vector<double> ts_;
+  std::vector<Value> vals_;
+};
+
+/**
+ * @brief Largest number of variables (1 + Nx + Nu) for which FlatDyn uses fixed-size dense derivative kernels.
+ *
+ * Above this size the derivatives are computed with sparse matrices.
+ */
+static constexpr int kFlatDynDenseMaxVars = 16;
+
 /**
  * @brief Flattening of dynamics function (t, x, u) -> Tangent, and its derivatives.
  *
+ * @tparam Dense use fixed-size dense derivative kernels (default for problems with at most kFlatDynDenseMaxVars
+ * variables), otherwise sparse kernels
+ *
  * @note Do not use numeric differentiation of operator() (it differentiates inside)
  * @note Only considers first derivative of xl and ul
  */
-template<LieGroup X, Manifold U, typename F, typename Xl, typename Ul>
+template<
+  LieGroup X,
+  Manifold U,
+  typename F,
+  typename Ref,
+  bool Dense = (1 + Dof<X> + Dof<U> <= kFlatDynDenseMaxVars)>
 class FlatDyn
 {
 private:
@@ -101,12 +207,17 @@ private:
   static constexpr auto x_B = t_B + 1;
   static constexpr auto u_B = x_B + Nx;
 
+  // small problems use fixed-size dense kernels
+  static constexpr bool kDense = Dense;
+
   using E = Tangent<X>;
   using V = Tangent<U>;
 
+  using JacT  = std::conditional_t<kDense, Eigen::Matrix<double, Nouts, Nvars>, Eigen::SparseMatrix<double>>;
+  using HessT = std::conditional_t<kDense, Eigen::Matrix<double, Nvars, Nouts * Nvars>, Eigen::SparseMatrix<double>>;
+
   F f;
-  Xl xl;
-  Ul ul;
+  std::shared_ptr<const Ref> ref;
 
   Eigen::SparseMatrix<double> ad_e_ = smooth::ad_sparse_pattern<X>;
   Eigen::SparseMatrix<double> ad_vi = smooth::ad_sparse_pattern<X>;
@@ -117,12 +228,18 @@ private:
   Eigen::SparseMatrix<double> dexpinv_e_  = smooth::d_exp_sparse_pattern<X>;
   Eigen::SparseMatrix<double> d2expinv_e_ = smooth::d2_exp_sparse_pattern<X>;
 
-  Eigen::SparseMatrix<double> J_{Nouts, Nvars};
-  Eigen::SparseMatrix<double> H_{Nvars, Nouts * Nvars};
+  JacT J_, ji_, ji_tmp_;
+  HessT H_, hi_, hi_tmp_;
 
-  // Would ideally like to remove these temporaries...
-  Eigen::SparseMatrix<double> ji_{Nouts, Nvars}, ji_tmp_{Nouts, Nvars}, hi_{Nvars, Nouts *Nvars},
-    hi_tmp_{Nvars, Nouts *Nvars};
+  // truncation of Bernoulli series in hessian()
+  double series_tol_{1e-12};
+  std::size_t series_terms_{0};
+
+  /// @brief True if the series term with Bernoulli number kBn[iter] and norm |coef| * |hi_| is negligible w.r.t. H_
+  bool series_converged(std::size_t iter, double coef) const
+  {
+    return iter > 1 && std::abs(kBn[iter] * coef) * hi_.norm() < series_tol_ * H_.norm();
+  }
 
   /// @brief Calculate jacobian of (t, x(t)+e, u(t)+v) w.r.t. (t, e, v)
   void update_joplus(const E & e, const V & v, const E & dxl, const V & dul)
@@ -158,35 +275,176 @@ private:
     Hoplus_.makeCompressed();
   }
 
+  /**
+   * @brief Fixed-size dense version of the Bernoulli series in hessian().
+   *
+   * @param vi value of f - dxl
+   * @param e tangent state
+   * @param Jf jacobian of f
+   * @param Hf hessian of f
+   *
+   * @note Requires Joplus_ and Hoplus_ to be up to date.
+   */
+  void hessian_dense(Tangent<X> vi, const E & e, const auto & Jf, const auto & Hf) requires(kDense)
+  {
+    const Eigen::Matrix<double, Nouts, Nvars> Jf_d(Jf);
+    const Eigen::Matrix<double, Nvars, Nouts * Nvars> Hf_d(Hf);
+    const Eigen::Matrix<double, Nvars, Nvars> Joplus_d(Joplus_);
+    const TangentMap<X> ad_e = ad<X>(e);
+
+    // d2r (f o (+)): Joplus' * Hf * Joplus + Jf * Hoplus
+    for (auto no = 0u; no < Nouts; ++no) {
+      hi_.template middleCols<Nvars>(no * Nvars).noalias() =
+        Joplus_d.transpose() * Hf_d.template middleCols<Nvars>(no * Nvars) * Joplus_d;
+      for (auto ny = 0u; ny < Nvars; ++ny) {
+        if (Jf_d(no, ny) != 0) {
+          hi_.template middleCols<Nvars>(no * Nvars) += Jf_d(no, ny) * Hoplus_.middleCols(ny * Nvars, Nvars);
+        }
+      }
+    }
+
+    double coef   = 1;                 // hold (-1)^i / i!
+    ji_.noalias() = Jf_d * Joplus_d;  // dr (vi)_{t, e, v}
+
+    H_.setZero();
+    series_terms_ = std::tuple_size_v<decltype(kBn)>;
+    for (auto iter = 0u; iter < std::tuple_size_v<decltype(kBn)>; ++iter) {
+      if (kBn[iter] != 0) {
+        if (series_converged(iter, coef)) {
+          series_terms_ = iter;
+          break;
+        }
+        H_ += (kBn[iter] * coef) * hi_;
+      }
+
+      // update hi_
+      hi_tmp_.setZero();
+      for (auto r = 0u; r < Nx; ++r) {
+        for (auto c = 0u; c < Nx; ++c) {
+          if (ad_e(r, c) != 0) {
+            hi_tmp_.template middleCols<Nvars>(r * Nvars) += ad_e(r, c) * hi_.template middleCols<Nvars>(c * Nvars);
+          }
+        }
+      }
+      for (auto k = 0u; k < Nx; ++k) {
+        hi_tmp_.template block<Nx, Nvars>(1, k * Nvars) += generators_sparse_reordered<X>[k] * ji_;
+        hi_tmp_.template block<Nvars, Nx>(0, k * Nvars + 1) -= ji_.transpose() * generators_sparse_reordered<X>[k];
+      }
+      hi_.swap(hi_tmp_);
+
+      // update ji
+      ji_tmp_.noalias() = ad_e * ji_;
+      ji_tmp_.template middleCols<Nx>(1) -= ad<X>(vi);
+      ji_.swap(ji_tmp_);
+
+      // update vi
+      vi.applyOnTheLeft(ad_e);
+
+      coef *= (-1.) / (iter + 1);
+    }
+  }
+
+  /// @brief Sparse version of the Bernoulli series in hessian().
+  void hessian_sparse(Tangent<X> vi, const E & e, const auto & Jf, const auto & Hf) requires(!kDense)
+  {
+    ad_sparse<X>(ad_e_, e);
+
+    double coef = 1;              // hold (-1)^i / i!
+    ji_         = Jf * Joplus_;  // dr (vi)_{t, e, v}
+    set_zero(hi_);
+    d2r_fog(hi_, Jf, Hf, Joplus_, Hoplus_);  // d2r (vi)_{t, e, v}
+
+    set_zero(H_);
+    series_terms_ = std::tuple_size_v<decltype(kBn)>;
+    for (auto iter = 0u; iter < std::tuple_size_v<decltype(kBn)>; ++iter) {
+      if (kBn[iter] != 0) {
+        if (series_converged(iter, coef)) {
+          series_terms_ = iter;
+          break;
+        }
+        block_add(H_, 0, 0, hi_, kBn[iter] * coef);
+      }
+
+      // update hi_
+      hi_tmp_.setZero();
+      for (auto i = 0u; i < ad_e_.outerSize(); ++i) {
+        for (Eigen::InnerIterator it(ad_e_, i); it; ++it) {
+          const auto b0 = it.row() * Nvars;
+          block_add(hi_tmp_, 0, b0, hi_.middleCols(it.col() * Nvars, Nvars), it.value());
+        }
+      }
+      for (auto k = 0u; k < Nx; ++k) {
+        const auto b0 = k * Nvars;
+        block_add(hi_tmp_, 1, b0, generators_sparse_reordered<X>[k] * ji_);
+        block_add(hi_tmp_, 0, b0 + 1, ji_.transpose() * generators_sparse_reordered<X>[k], -1);
+      }
+      std::swap(hi_, hi_tmp_);
+
+      // update ji
+      ji_tmp_.setZero();
+      ji_tmp_ = ad_e_ * ji_;
+      ad_sparse<X>(ad_vi, vi);
+      block_add(ji_tmp_, 0, 1, ad_vi, -1);
+      std::swap(ji_, ji_tmp_);
+
+      // update vi
+      vi.applyOnTheLeft(ad_e_);
+
+      coef *= (-1.) / (iter + 1);
+    }
+
+    H_.makeCompressed();
+  }
+
 public:
-  template<typename A1, typename A2, typename A3>
-  FlatDyn(A1 && a1, A2 && a2, A3 && a3) : f(std::forward<A1>(a1)), xl(std::forward<A2>(a2)), ul(std::forward<A3>(a3))
-  {}
+  template<typename A1>
+  FlatDyn(A1 && a1, std::shared_ptr<const Ref> a2) : f(std::forward<A1>(a1)), ref(std::move(a2))
+  {
+    if constexpr (kDense) {
+      J_.setZero();
+      ji_.setZero();
+      ji_tmp_.setZero();
+      H_.setZero();
+      hi_.setZero();
+      hi_tmp_.setZero();
+    } else {
+      J_.resize(Nouts, Nvars);
+      ji_.resize(Nouts, Nvars);
+      ji_tmp_.resize(Nouts, Nvars);
+      H_.resize(Nvars, Nouts * Nvars);
+      hi_.resize(Nvars, Nouts * Nvars);
+      hi_tmp_.resize(Nvars, Nouts * Nvars);
+    }
+  }
 
   template<typename T>
   CastT<T, E> operator()(const T & t, const CastT<T, E> & e, const CastT<T, V> & v) const
   {
     using XT = CastT<T, X>;
 
+    if constexpr (std::is_same_v<T, double>) {
+      if (const auto * r = ref->find(t)) {
+        return dr_expinv<X>(e) * (f(t, rplus(r->xl, e), rplus(r->ul, v)) - r->dxl) + ad<X>(e) * r->dxl;
+      }
+    }
+
     // can not double-differentiate, so we hide derivative of xl w.r.t. t
-    const double tdbl           = static_cast<double>(t);
-    const auto [unused, dxlval] = diff::dr<1>(xl, wrt(tdbl));
+    const Tangent<X> dxlval = ref->dxl(static_cast<double>(t));
 
-    return dr_expinv<XT>(e) * (f(t, rplus(xl(t), e), rplus(ul(t), v)) - dxlval.template cast<T>())
+    return dr_expinv<XT>(e) * (f(t, rplus(ref->xl(t), e), rplus(ref->ul(t), v)) - dxlval.template cast<T>())
          + ad<XT>(e) * dxlval.template cast<T>();
   }
 
   // First derivative
-  std::reference_wrapper<const Eigen::SparseMatrix<double>>
+  std::reference_wrapper<const JacT>
   jacobian(double t, const E & e, const V & v) requires(diff::detail::diffable_order1<F, std::tuple<double, X, U>>)
   {
-    const double tdbl          = static_cast<double>(t);
-    const auto [xlval, dxlval] = diff::dr<1>(xl, wrt(tdbl));
-    const auto [ulval, dulval] = diff::dr<1>(ul, wrt(tdbl));
-    const auto x               = rplus(xlval, e);
-    const auto u               = rplus(ulval, v);
+    const auto [xlval, dxlval, ulval, dulval] = (*ref)(t);
+
+    const auto x = rplus(xlval, e);
+    const auto u = rplus(ulval, v);
 
-    dr_expinv_sparse<X>(dexpinv_e_, e);
+    if constexpr (!kDense) { dr_expinv_sparse<X>(dexpinv_e_, e); }
     d2r_expinv_sparse<X>(d2expinv_e_, e);
     update_joplus(e, v, dxlval, dulval);
 
@@ -197,7 +455,13 @@ public:
     // Want to differentiate  drexpinv * (f o plus - dxl) + ad dxl
 
     // Start with drexpinv * d (f \circ (+))
-    J_ = dexpinv_e_ * Jf * Joplus_;
+    if constexpr (kDense) {
+      const Eigen::Matrix<double, Nouts, Nvars> Jf_d(Jf);
+      const Eigen::Matrix<double, Nvars, Nvars> Joplus_d(Joplus_);
+      J_.noalias() = dr_expinv<X>(e) * Jf_d * Joplus_d;
+    } else {
+      J_ = dexpinv_e_ * Jf * Joplus_;
+    }
     // Add d ( drexpinv ) * (f \circ (+) - dxl)
     for (auto i = 0u; i < d2expinv_e_.outerSize(); ++i) {
       for (Eigen::InnerIterator it(d2expinv_e_, i); it; ++it) {
@@ -211,70 +475,47 @@ public:
       }
     }
 
-    J_.makeCompressed();
+    if constexpr (!kDense) { J_.makeCompressed(); }
     return J_;
   }
 
   // Second derivative
   //    \sum Bn (-1)^n / n! d2r (ad_a^n f)_aa - \sum Bn / n! d2r(ad_a^n dxl)_aa
-  std::reference_wrapper<const Eigen::SparseMatrix<double>>
+  std::reference_wrapper<const HessT>
   hessian(double t, const E & e, const V & v) requires(diff::detail::diffable_order1<F, std::tuple<double, X, U>> &&
                                                          diff::detail::diffable_order2<F, std::tuple<double, X, U>>)
   {
-    const double tdbl          = static_cast<double>(t);
-    const auto [xlval, dxlval] = diff::dr<1>(xl, wrt(tdbl));
-    const auto [ulval, dulval] = diff::dr<1>(ul, wrt(tdbl));
+    const auto [xlval, dxlval, ulval, dulval] = (*ref)(t);
 
     const auto x    = rplus(xlval, e);
-    const auto u    = rplus(ul(t), v);
+    const auto u    = rplus(ulval, v);
     const auto & Jf = f.jacobian(t, x, u);  // nx x (1 + nx + nu)
     const auto & Hf = f.hessian(t, x, u);   // (1 + nx + nu) x (nx * (1 + nx + nu))
 
-    ad_sparse<X>(ad_e_, e);
     update_joplus(e, v, dxlval, dulval);
     update_hoplus(e, v, dxlval, dulval);
 
-    double coef   = 1;                    // hold (-1)^i / i!
-    Tangent<X> vi = f(t, x, u) - dxlval;  // (ad_a)^i * (f - dxl)
-    ji_           = Jf * Joplus_;         // dr (vi)_{t, e, v}
-    set_zero(hi_);
-    d2r_fog(hi_, Jf, Hf, Joplus_, Hoplus_);  // d2r (vi)_{t, e, v}
-
-    set_zero(H_);
-    for (auto iter = 0u; iter < std::tuple_size_v<decltype(kBn)>; ++iter) {
-      if (kBn[iter] != 0) { block_add(H_, 0, 0, hi_, kBn[iter] * coef); }
-
-      // update hi_
-      hi_tmp_.setZero();
-      for (auto i = 0u; i < ad_e_.outerSize(); ++i) {
-        for (Eigen::InnerIterator it(ad_e_, i); it; ++it) {
-          const auto b0 = it.row() * Nvars;
-          block_add(hi_tmp_, 0, b0, hi_.middleCols(it.col() * Nvars, Nvars), it.value());
-        }
-      }
-      for (auto k = 0u; k < Nx; ++k) {
-        const auto b0 = k * Nvars;
-        block_add(hi_tmp_, 1, b0, generators_sparse_reordered<X>[k] * ji_);
-        block_add(hi_tmp_, 0, b0 + 1, ji_.transpose() * generators_sparse_reordered<X>[k], -1);
-      }
-      std::swap(hi_, hi_tmp_);
-
-      // update ji
-      ji_tmp_.setZero();
-      ji_tmp_ = ad_e_ * ji_;
-      ad_sparse<X>(ad_vi, vi);
-      block_add(ji_tmp_, 0, 1, ad_vi, -1);
-      std::swap(ji_, ji_tmp_);
-
-      // update vi
-      vi.applyOnTheLeft(ad_e_);
-
-      coef *= (-1.) / (iter + 1);
+    if constexpr (kDense) {
+      hessian_dense(f(t, x, u) - dxlval, e, Jf, Hf);
+    } else {
+      hessian_sparse(f(t, x, u) - dxlval, e, Jf, Hf);
     }
 
-    H_.makeCompressed();
     return H_;
   }
+
+  /**
+   * @brief Set truncation tolerance of the series in hessian().
+   *
+   * The series is truncated at the first term whose norm is smaller than tol times the norm of the partial sum.
+   * Terms decay geometrically with |e|, so fewer terms are required close to the linearization point.
+   *
+   * @param tol relative tolerance (set to zero to always evaluate all terms)
+   */
+  void set_series_tol(double tol) { series_tol_ = tol; }
+
+  /// @brief Number of series terms evaluated in the last call to hessian()
+  std::size_t series_terms() const { return series_terms_; }
 };
 
 /**
@@ -282,15 +523,14 @@ public:
  *
  * @note Only considers first derivative of xl and ul
  */
-template<LieGroup X, Manifold U, std::size_t Nouts, typename F, typename Xl, typename Ul>
+template<LieGroup X, Manifold U, std::size_t Nouts, typename F, typename Ref>
 class FlatInnerFun
 {
 private:
   using BundleT = smooth::Bundle<Eigen::Vector<double, 1>, X, U>;
 
   F f;
-  Xl xl;
-  Ul ul;
+  std::shared_ptr<const Ref> ref;
 
   static constexpr auto Nx    = Dof<X>;
   static constexpr auto Nu    = Dof<U>;
@@ -344,23 +584,22 @@ private:
   }
 
 public:
-  template<typename A1, typename A2, typename A3>
-  FlatInnerFun(A1 && a1, A2 && a2, A3 && a3)
-      : f(std::forward<A1>(a1)), xl(std::forward<A2>(a2)), ul(std::forward<A3>(a3))
+  template<typename A1>
+  FlatInnerFun(A1 && a1, std::shared_ptr<const Ref> a2) : f(std::forward<A1>(a1)), ref(std::move(a2))
   {}
 
   template<typename T>
   Eigen::Vector<T, Nouts> operator()(const T & t, const CastT<T, E> & e, const CastT<T, V> & v) const
   {
-    return f.template operator()<T>(t, rplus(xl(t), e), rplus(ul(t), v));
+    return f.template operator()<T>(t, rplus(ref->xl(t), e), rplus(ref->ul(t), v));
   }
 
   std::reference_wrapper<const Eigen::SparseMatrix<double>>
   jacobian(double t, const E & e, const V & v) requires(diff::detail::diffable_order1<F, std::tuple<double, X, U>>)
   {
-    const auto & [xlval, dxlval] = diff::dr<1>(xl, wrt(t));
-    const auto & [ulval, dulval] = diff::dr<1>(ul, wrt(t));
-    const auto & Jf              = f.jacobian(t, rplus(xlval, e), rplus(ulval, v));
+    const auto [xlval, dxlval, ulval, dulval] = (*ref)(t);
+
+    const auto & Jf = f.jacobian(t, rplus(xlval, e), rplus(ulval, v));
 
     update_joplus(e, v, dxlval, dulval);
 
@@ -373,12 +612,12 @@ public:
   hessian(double t, const E & e, const V & v) requires(diff::detail::diffable_order1<F, std::tuple<double, X, U>> &&
                                                          diff::detail::diffable_order2<F, std::tuple<double, X, U>>)
   {
-    const auto & [xlval, dxlval] = diff::dr<1>(xl, wrt(t));
-    const auto & [ulval, dulval] = diff::dr<1>(ul, wrt(t));
-    const auto x                 = rplus(xlval, e);
-    const auto u                 = rplus(ulval, v);
-    const auto & Jf              = f.jacobian(t, x, u);
-    const auto & Hf              = f.hessian(t, x, u);
+    const auto [xlval, dxlval, ulval, dulval] = (*ref)(t);
+
+    const auto x    = rplus(xlval, e);
+    const auto u    = rplus(ulval, v);
+    const auto & Jf = f.jacobian(t, x, u);
+    const auto & Hf = f.hessian(t, x, u);
 
     update_joplus(e, v, dxlval, dulval);
     update_hoplus(e, v, dxlval, dulval);
@@ -395,7 +634,7 @@ public:
  *
  * @note Only considers first derivative of xl
  */
-template<LieGroup X, Manifold U, std::size_t Nq, std::size_t Nouts, typename F, typename Xl>
+template<LieGroup X, Manifold U, std::size_t Nq, std::size_t Nouts, typename F, typename Ref>
 class FlatEndptFun
 {
 private:
@@ -404,7 +643,7 @@ private:
   using BundleT = smooth::Bundle<Eigen::Vector<double, 1>, X, X, Q>;
 
   F f;
-  Xl xl;
+  std::shared_ptr<const Ref> ref;
 
   static constexpr auto Nx    = Dof<X>;
   static constexpr auto Nvars = 1 + 2 * Nx + Nq;
@@ -448,24 +687,26 @@ private:
   }
 
 public:
-  template<typename A1, typename A2>
-  FlatEndptFun(A1 && a1, A2 && a2) : f(std::forward<A1>(a1)), xl(std::forward<A2>(a2))
+  template<typename A1>
+  FlatEndptFun(A1 && a1, std::shared_ptr<const Ref> a2) : f(std::forward<A1>(a1)), ref(std::move(a2))
   {}
 
   template<typename T>
   auto operator()(const T & tf, const CastT<T, E> & e0, const CastT<T, E> & ef, const CastT<T, Q> & q) const
   {
-    return f.template operator()<T>(tf, rplus(xl(T(0.)), e0), rplus(xl(tf), ef), q);
+    return f.template operator()<T>(tf, rplus(ref->xl(T(0.)), e0), rplus(ref->xl(tf), ef), q);
   }
 
   std::reference_wrapper<const Eigen::SparseMatrix<double>>
   jacobian(double tf, const E & e0, const E & ef, const Q & q) requires(
     diff::detail::diffable_order1<F, std::tuple<double, X, X, Q>>)
   {
-    const auto & [xlfval, dxlfval] = diff::dr<1>(xl, wrt(tf));
-    const auto & Jf                = f.jacobian(tf, rplus(xl(0.), e0), rplus(xlfval, ef), q);
+    const auto r0 = (*ref)(0.);
+    const auto rf = (*ref)(tf);
+
+    const auto & Jf = f.jacobian(tf, rplus(r0.xl, e0), rplus(rf.xl, ef), q);
 
-    update_joplus(e0, ef, dxlfval);
+    update_joplus(e0, ef, rf.dxl);
 
     J_ = Jf * Joplus_;
     J_.makeCompressed();
@@ -477,14 +718,16 @@ public:
     diff::detail::diffable_order1<F, std::tuple<double, X, X, Q>> &&
       diff::detail::diffable_order2<F, std::tuple<double, X, X, Q>>)
   {
-    const auto & [xlfval, dxlfval] = diff::dr<1>(xl, wrt(tf));
-    const auto x0                  = rplus(xl(0.), e0);
-    const auto xf                  = rplus(xlfval, ef);
-    const auto & Jf                = f.jacobian(tf, x0, xf, q);  // Nouts x Nx
-    const auto & Hf                = f.hessian(tf, x0, xf, q);   // Nx x (Nouts * Nx)
+    const auto r0 = (*ref)(0.);
+    const auto rf = (*ref)(tf);
 
-    update_joplus(e0, ef, dxlfval);
-    update_hoplus(e0, ef, dxlfval);
+    const auto x0   = rplus(r0.xl, e0);
+    const auto xf   = rplus(rf.xl, ef);
+    const auto & Jf = f.jacobian(tf, x0, xf, q);  // Nouts x Nx
+    const auto & Hf = f.hessian(tf, x0, xf, q);   // Nx x (Nouts * Nx)
+
+    update_joplus(e0, ef, rf.dxl);
+    update_hoplus(e0, ef, rf.dxl);
 
     set_zero(H_);
     d2r_fog(H_, Jf, Hf, Joplus_, Hoplus_);
@@ -496,6 +739,41 @@ public:
 }  // namespace detail
 // \endcond
 
+// \cond
+namespace detail {
+
+/// @brief Flatten ocp around a shared reference
+template<typename Ocp, typename Ref>
+auto flatten_ocp_impl(const Ocp & ocp, std::shared_ptr<const Ref> ref)
+{
+  using X = typename Ocp::X;
+  using U = typename Ocp::U;
+
+  static constexpr auto Nq = Ocp::Nq;
+
+  return OCP<
+    Tangent<X>,
+    Tangent<U>,
+    FlatEndptFun<X, U, Nq, 1, decltype(ocp.theta), Ref>,
+    FlatDyn<X, U, decltype(ocp.f), Ref>,
+    FlatInnerFun<X, U, Nq, decltype(ocp.g), Ref>,
+    FlatInnerFun<X, U, Ocp::Ncr, decltype(ocp.cr), Ref>,
+    FlatEndptFun<X, U, Nq, Ocp::Nce, decltype(ocp.ce), Ref>>{
+    .theta = FlatEndptFun<X, U, Nq, 1, decltype(ocp.theta), Ref>{ocp.theta, ref},
+    .f     = FlatDyn<X, U, decltype(ocp.f), Ref>{ocp.f, ref},
+    .g     = FlatInnerFun<X, U, Nq, decltype(ocp.g), Ref>{ocp.g, ref},
+    .cr    = FlatInnerFun<X, U, Ocp::Ncr, decltype(ocp.cr), Ref>{ocp.cr, ref},
+    .crl   = ocp.crl,
+    .cru   = ocp.cru,
+    .ce    = FlatEndptFun<X, U, Nq, Ocp::Nce, decltype(ocp.ce), Ref>{ocp.ce, ref},
+    .cel   = ocp.cel,
+    .ceu   = ocp.ceu,
+  };
+}
+
+}  // namespace detail
+// \endcond
+
 /**
  * @brief Flatten a LieGroup OCP by defining it in the tangent space around a trajectory.
  *
@@ -513,31 +791,46 @@ public:
 auto flatten_ocp(const OCPType auto & ocp, auto && xl, auto && ul)
 {
   using ocp_t = std::decay_t<decltype(ocp)>;
-  using X     = typename ocp_t::X;
-  using U     = typename ocp_t::U;
-  using Xl    = decltype(xl);
-  using Ul    = decltype(ul);
 
-  static constexpr auto Nq = ocp_t::Nq;
+  // store references to lvalues and copies of rvalues
+  using Xl  = std::conditional_t<std::is_lvalue_reference_v<decltype(xl)>, decltype(xl), std::decay_t<decltype(xl)>>;
+  using Ul  = std::conditional_t<std::is_lvalue_reference_v<decltype(ul)>, decltype(ul), std::decay_t<decltype(ul)>>;
+  using Ref = detail::FlatReference<typename ocp_t::X, typename ocp_t::U, Xl, Ul>;
 
-  return OCP<
-    Tangent<X>,
-    Tangent<U>,
-    detail::FlatEndptFun<X, U, Nq, 1, decltype(ocp.theta), Xl>,
-    detail::FlatDyn<X, U, decltype(ocp.f), Xl, Ul>,
-    detail::FlatInnerFun<X, U, Nq, decltype(ocp.g), Xl, Ul>,
-    detail::FlatInnerFun<X, U, ocp_t::Ncr, decltype(ocp.cr), Xl, Ul>,
-    detail::FlatEndptFun<X, U, Nq, ocp_t::Nce, decltype(ocp.ce), Xl>>{
-    .theta = detail::FlatEndptFun<X, U, Nq, 1, decltype(ocp.theta), Xl>{ocp.theta, xl},
-    .f     = detail::FlatDyn<X, U, decltype(ocp.f), Xl, Ul>{ocp.f, xl, ul},
-    .g     = detail::FlatInnerFun<X, U, Nq, decltype(ocp.g), Xl, Ul>{ocp.g, xl, ul},
-    .cr    = detail::FlatInnerFun<X, U, ocp_t::Ncr, decltype(ocp.cr), Xl, Ul>{ocp.cr, xl, ul},
-    .crl   = ocp.crl,
-    .cru   = ocp.cru,
-    .ce    = detail::FlatEndptFun<X, U, Nq, ocp_t::Nce, decltype(ocp.ce), Xl>{ocp.ce, xl},
-    .cel   = ocp.cel,
-    .ceu   = ocp.ceu,
-  };
+  // linearization trajectory is shared between all functors
+  return detail::flatten_ocp_impl(
+    ocp, std::make_shared<const Ref>(std::forward<decltype(xl)>(xl), std::forward<decltype(ul)>(ul)));
+}
+
+/**
+ * @brief Flatten a LieGroup OCP and precompute the linearization trajectory at the collocation nodes of a mesh.
+ *
+ * Evaluations of the flattened problem at the node times t = tf * tau of \p mesh do not differentiate \p xl or
+ * \p ul, other times are evaluated as in flatten_ocp(ocp, xl, ul).
+ *
+ * @param ocp OCPType defined on a LieGroup
+ * @param xl nominal state trajectory
+ * @param ul nominal state trajectory
+ * @param mesh collocation mesh
+ * @param tf final time
+ *
+ * @note Precomputed values are not updated if \p xl or \p ul are passed as lvalues and modified afterwards.
+ */
+auto flatten_ocp(const OCPType auto & ocp, auto && xl, auto && ul, const MeshType auto & mesh, const double tf)
+{
+  using ocp_t = std::decay_t<decltype(ocp)>;
+
+  using Xl  = std::conditional_t<std::is_lvalue_reference_v<decltype(xl)>, decltype(xl), std::decay_t<decltype(xl)>>;
+  using Ul  = std::conditional_t<std::is_lvalue_reference_v<decltype(ul)>, decltype(ul), std::decay_t<decltype(ul)>>;
+  using Ref = detail::FlatReference<typename ocp_t::X, typename ocp_t::U, Xl, Ul>;
+
+  std::vector<double> ts;
+  ts.reserve(mesh.N_colloc() + 1);
+  for (const double tau : mesh.all_nodes()) { ts.push_back(tf * tau); }
+
+  return detail::flatten_ocp_impl(
+    ocp,
+    std::make_shared<const Ref>(std::forward<decltype(xl)>(xl), std::forward<decltype(ul)>(ul), std::move(ts)));
 }
 
 /**
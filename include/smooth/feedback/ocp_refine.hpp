@@ -0,0 +1,189 @@
+// Copyright (C) 2022 Petter Nilsson. MIT License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Solve optimal control problems with adaptive mesh refinement.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include <Eigen/Core>
+
+#include "collocation/dyn_error.hpp"
+#include "collocation/mesh.hpp"
+#include "nlp_solver.hpp"
+#include "ocp.hpp"
+#include "ocp_to_nlp.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace smooth::feedback {
+
+/**
+ * @brief Parameters for solve_ocp_refine().
+ */
+struct OCPRefineParams
+{
+  /// target relative dynamics error in every mesh interval
+  double target_err = 1e-6;
+
+  /// intervals are refined to reach refine_factor * target_err (@see Mesh::refine_errors())
+  double refine_factor = 0.1;
+
+  /// max number of solve-refine iterations
+  std::size_t max_iter = 10;
+
+  /// refinement stops if the refined mesh would have more collocation points than this
+  std::size_t max_colloc = 2000;
+
+  /// number of threads used for error estimation (@see mesh_dyn_error())
+  std::size_t n_threads = 1;
+
+  /// print progress information to stdout
+  bool verbose = false;
+};
+
+/**
+ * @brief Result of solve_ocp_refine().
+ *
+ * @tparam Sol OCP solution type
+ */
+template<typename Sol>
+struct OCPRefineResult
+{
+  /// @brief OCP solution on the final mesh
+  Sol ocpsol;
+
+  /// @brief NLP solution on the final mesh
+  NLPSolution nlpsol;
+
+  /// @brief Relative dynamics errors for each interval of the final mesh
+  Eigen::VectorXd errs;
+
+  /// @brief Number of solve-refine iterations
+  std::size_t iter{0};
+
+  /// @brief True if all interval errors satisfy the target error
+  bool converged{false};
+};
+
+// \cond
+namespace detail {
+
+/// @brief Callback that does nothing.
+struct OCPRefineNoop
+{
+  void operator()(auto &&...) const noexcept {}
+};
+
+}  // namespace detail
+// \endcond
+
+/**
+ * @brief Solve an OCP with hp-adaptive mesh refinement.
+ *
+ * In each iteration the OCP is transcribed on the current mesh and solved as a NLP, after which relative
+ * dynamics errors are estimated for every mesh interval (in parallel if OCPRefineParams::n_threads > 1). Intervals
+ * with too large errors are refined, and the primal and dual solution is interpolated onto the refined mesh to
+ * warm-start the next solve.
+ *
+ * Iteration stops when all interval errors are below OCPRefineParams::target_err, when the refined mesh would
+ * exceed OCPRefineParams::max_colloc collocation points, or after OCPRefineParams::max_iter iterations.
+ *
+ * @tparam DT differentiation method for the NLP
+ *
+ * @param ocp flat optimal control problem
+ * @param mesh mesh to start from, on return it holds the mesh of the returned solution
+ * @param solver either a NLPSolver, or a callable with signature
+ * `NLPSolution(NLP & nlp, const std::optional<NLPSolution> & warmstart)`.
+ * @param prm refinement parameters
+ * @param warmstart initial guess for the NLP on the initial mesh
+ * @param callback invoked as `callback(iter, mesh, ocpsol, errs)` after the error estimation in every iteration
+ *
+ * @return OCPRefineResult with solution on the final mesh
+ *
+ * @note When solver is a NLPSolver its working memory is only re-allocated when the problem size changes.
+ * @note The mesh must support refinement (i.e. it can not be a FixedMesh).
+ */
+template<diff::Type DT = diff::Type::Default, typename Solver, typename Callback = detail::OCPRefineNoop>
+auto solve_ocp_refine(
+  const FlatOCPType auto & ocp,
+  MeshType auto & mesh,
+  Solver && solver,
+  const OCPRefineParams & prm          = {},
+  std::optional<NLPSolution> warmstart = {},
+  Callback && callback                 = {})
+{
+  using Sol = decltype(nlpsol_to_ocpsol(ocp, mesh, std::declval<const NLPSolution &>()));
+
+  std::optional<OCPRefineResult<Sol>> ret;
+
+  // error estimation threads are shared by all iterations
+  ThreadPool pool(prm.n_threads);
+
+  for (auto iter = 0u; iter < std::max<std::size_t>(prm.max_iter, 1); ++iter) {
+    if (prm.verbose) {
+      std::cout << "---------- ITERATION " << iter << " ----------" << std::endl;
+      std::cout << "mesh: " << mesh.N_ivals() << " intervals, " << mesh.N_colloc() << " collocation pts" << std::endl;
+    }
+
+    // transcribe and solve on current mesh
+    auto nlp = ocp_to_nlp<DT>(ocp, mesh);
+
+    NLPSolution nlpsol;
+    if constexpr (std::is_same_v<std::decay_t<Solver>, NLPSolver>) {
+      if (warmstart.has_value()) {
+        nlpsol = solver.solve(nlp, std::cref(warmstart.value()));
+      } else {
+        nlpsol = solver.solve(nlp);
+      }
+    } else {
+      nlpsol = solver(nlp, std::as_const(warmstart));
+    }
+
+    auto ocpsol = nlpsol_to_ocpsol(ocp, mesh, nlpsol);
+
+    // estimate errors with one degree higher than the solution
+    mesh.increase_degrees();
+    Eigen::VectorXd errs = mesh_dyn_error(ocp.f, mesh, ocpsol.t0, ocpsol.tf, ocpsol.x, ocpsol.u, &pool);
+    mesh.decrease_degrees();
+
+    if (prm.verbose) { std::cout << "max interval error " << errs.maxCoeff() << std::endl; }
+
+    callback(static_cast<std::size_t>(iter), std::as_const(mesh), std::as_const(ocpsol), std::as_const(errs));
+
+    const bool converged = errs.maxCoeff() <= prm.target_err;
+
+    ret.emplace(OCPRefineResult<Sol>{
+      .ocpsol    = std::move(ocpsol),
+      .nlpsol    = std::move(nlpsol),
+      .errs      = std::move(errs),
+      .iter      = iter + 1,
+      .converged = converged,
+    });
+
+    if (converged || iter + 1 >= prm.max_iter) { break; }
+
+    // refine a copy to respect the node budget
+    auto refined = mesh;
+    refined.refine_errors(ret->errs, prm.refine_factor * prm.target_err);
+    if (refined.N_colloc() > prm.max_colloc) {
+      if (prm.verbose) { std::cout << "collocation point budget exceeded" << std::endl; }
+      break;
+    }
+    mesh = std::move(refined);
+
+    // interpolate primal and dual solution onto refined mesh
+    warmstart = ocpsol_to_nlpsol(ocp, mesh, ret->ocpsol);
+  }
+
+  return std::move(ret.value());
+}
+
+}  // namespace smooth::feedback
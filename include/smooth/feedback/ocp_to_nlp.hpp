@@ -10,10 +10,17 @@
 #include <Eigen/Core>
 #include <smooth/concepts/lie_group.hpp>
 
+#include <memory>
+#include <span>
+#include <vector>
+
 #include "collocation/mesh.hpp"
 #include "collocation/mesh_function.hpp"
+#include "collocation/piecewise_polynomial.hpp"
 #include "nlp.hpp"
 #include "ocp.hpp"
+#include "utils/sparse.hpp"
+#include "utils/thread_pool.hpp"
 
 namespace smooth::feedback {
 
@@ -50,6 +57,73 @@ auto ocp_nlp_structure(const FlatOCPType auto & ocp, const MeshType auto & mesh)
   return std::make_tuple(var_beg, var_len, con_beg, con_len);
 }
 
+/**
+ * @brief Structural sparsity pattern of the constraint Jacobian of an OCP NLP.
+ *
+ * The pattern is a superset of the nonzeros of OCPNLP::dg_dx() that follows from the per-node structure of the
+ * collocation: dynamics constraints on an interval depend on the states of that interval and the input at the node,
+ * running constraints depend on the state and input at the node, and end constraints depend on tf, x0, xf, q.
+ *
+ * @param ocp optimal control problem
+ * @param mesh collocation mesh
+ * @param with_integrals include the (dense) rows of the integral constraints
+ */
+Eigen::SparseMatrix<double>
+ocp_nlp_dg_dx_pattern(const FlatOCPType auto & ocp, const MeshType auto & mesh, bool with_integrals = true)
+{
+  const std::size_t Nx = ocp.Nx, Nu = ocp.Nu, Nq = ocp.Nq, Ncr = ocp.Ncr, Nce = ocp.Nce;
+
+  const std::size_t N                             = mesh.N_colloc();
+  const auto [var_beg, var_len, con_beg, con_len] = ocp_nlp_structure(ocp, mesh);
+
+  const auto [tfvar_B, qvar_B, xvar_B, uvar_B, n] = var_beg;
+  const auto [dcon_B, qcon_B, crcon_B, cecon_B, m] = con_beg;
+
+  std::vector<Eigen::Triplet<double>> triplets;
+
+  const auto add_block = [&](std::size_t r0, std::size_t nr, std::size_t c0, std::size_t nc) {
+    for (auto c = c0; c < c0 + nc; ++c) {
+      for (auto r = r0; r < r0 + nr; ++r) { triplets.emplace_back(r, c, 1.); }
+    }
+  };
+
+  // dynamics: tf, all states in interval, input at node
+  for (auto ival = 0u, i0 = 0u; ival < mesh.N_ivals(); i0 += mesh.N_colloc_ival(ival++)) {
+    const auto K = mesh.N_colloc_ival(ival);
+    for (auto i = i0; i < i0 + K; ++i) {
+      add_block(dcon_B + i * Nx, Nx, tfvar_B, 1);
+      add_block(dcon_B + i * Nx, Nx, xvar_B + i0 * Nx, (K + 1) * Nx);
+      add_block(dcon_B + i * Nx, Nx, uvar_B + i * Nu, Nu);
+    }
+  }
+
+  // integrals: tf, all states and inputs at collocation nodes, integral variables
+  if (with_integrals) {
+    add_block(qcon_B, Nq, tfvar_B, 1);
+    add_block(qcon_B, Nq, xvar_B, N * Nx);
+    add_block(qcon_B, Nq, uvar_B, N * Nu);
+    for (auto k = 0u; k < Nq; ++k) { add_block(qcon_B + k, 1, qvar_B + k, 1); }
+  }
+
+  // running constraints: tf, state and input at node
+  for (auto i = 0u; i < N; ++i) {
+    add_block(crcon_B + i * Ncr, Ncr, tfvar_B, 1);
+    add_block(crcon_B + i * Ncr, Ncr, xvar_B + i * Nx, Nx);
+    add_block(crcon_B + i * Ncr, Ncr, uvar_B + i * Nu, Nu);
+  }
+
+  // end constraints: tf, x0, xf, q
+  add_block(cecon_B, Nce, tfvar_B, 1);
+  add_block(cecon_B, Nce, xvar_B, Nx);
+  add_block(cecon_B, Nce, xvar_B + N * Nx, Nx);
+  add_block(cecon_B, Nce, qvar_B, Nq);
+
+  Eigen::SparseMatrix<double> ret(m, n);
+  ret.setFromTriplets(triplets.begin(), triplets.end(), [](double, double) { return 1.; });
+  ret.makeCompressed();
+  return ret;
+}
+
 /**
  * @brief NLP representing an OCP.
  *
@@ -83,6 +157,23 @@ private:
   Eigen::VectorXd g_;
   Eigen::SparseMatrix<double> df_dx_, dg_dx_, d2f_dx2_, d2g_dx2_;
 
+  // compressed finite differences
+  std::pair<Eigen::Index, Eigen::VectorXi> dg_dx_coloring_;
+  Eigen::SparseMatrix<double> dg_dx_cpr_;
+
+  /// @brief Constraint function of an NLP (used for threaded compressed finite differences)
+  struct GFun
+  {
+    OCPNLP * nlp;
+
+    const Eigen::VectorXd & operator()(const Eigen::Ref<const Eigen::VectorXd> x) const { return nlp->g(x); }
+  };
+
+  // per-thread copies of this NLP and worker threads for threaded compressed finite differences (created once)
+  std::vector<OCPNLP> cpr_workers_;
+  std::vector<GFun> cpr_funs_;
+  std::shared_ptr<ThreadPool> cpr_pool_;
+
   // allocated computation
   MeshValue<0> dyn_out0_, int_out0_, cr_out0_;
   MeshValue<1> dyn_out1_, int_out1_, cr_out1_;
@@ -281,6 +372,9 @@ public:
   {
     assert(static_cast<std::size_t>(x.size()) == n_);
 
+    // numerical differentiation is more efficient via compressed finite differences
+    if constexpr (DT == diff::Type::Numerical) { return dg_dx_cpr(x); }
+
     const auto x0var_B = xvar_B;
     const auto xfvar_B = xvar_B + xvar_L - Nx;
 
@@ -330,6 +424,67 @@ public:
     return dg_dx_;
   }
 
+  /**
+   * @brief Constraint Jacobian via compressed finite differences.
+   *
+   * Columns of the structural sparsity pattern (see ocp_nlp_dg_dx_pattern()) are colored with cpr_coloring(), so that
+   * the Jacobian is estimated from one evaluation of g() per color instead of one per variable. The dense rows of the
+   * integral constraints are excluded from the coloring and computed via mesh_integrate().
+   *
+   * @param x point of evaluation
+   * @param n_threads number of threads to distribute colors over (each additional thread uses a copy of this NLP;
+   * copies and threads are created in the first call with a given number of threads and re-used in later calls)
+   */
+  const Eigen::SparseMatrix<double> & dg_dx_cpr(const Eigen::Ref<const Eigen::VectorXd> x, std::size_t n_threads = 1)
+  {
+    assert(static_cast<std::size_t>(x.size()) == n_);
+
+    if (dg_dx_cpr_.size() == 0) {
+      dg_dx_cpr_      = ocp_nlp_dg_dx_pattern(ocp_, mesh_, false);
+      dg_dx_coloring_ = cpr_coloring(dg_dx_cpr_);
+    }
+
+    n_threads = std::max<std::size_t>(1, n_threads);
+    if (cpr_funs_.size() != n_threads || cpr_funs_.front().nlp != this) {
+      // workers are copied from this NLP without workers of their own
+      cpr_workers_.clear();
+      cpr_funs_.clear();
+      cpr_pool_.reset();
+      cpr_workers_.reserve(n_threads - 1);
+      for (auto i = 1u; i < n_threads; ++i) { cpr_workers_.push_back(*this); }
+
+      cpr_funs_.push_back(GFun{this});
+      for (auto & worker : cpr_workers_) { cpr_funs_.push_back(GFun{&worker}); }
+
+      // copies of this NLP share the pool until they create their own, so it is never used from two NLPs at once
+      if (n_threads > 1) { cpr_pool_ = std::make_shared<ThreadPool>(n_threads); }
+    }
+
+    fd_jacobian_colored(std::span(cpr_funs_), x, dg_dx_coloring_, dg_dx_cpr_, cpr_pool_.get());
+
+    const double t0 = 0;
+    const double tf = x(tfvar_B);
+
+    const Eigen::Map<const Eigen::Matrix<double, Nx, -1>> X(x.data() + xvar_B, Nx, N_ + 1);
+    const Eigen::Map<const Eigen::Matrix<double, Nu, -1>> U(x.data() + uvar_B, Nu, N_);
+
+    mesh_integrate<1, DT>(int_out1_, mesh_, ocp_.g, t0, tf, X.colwise(), U.colwise());
+    int_out1_.dF.makeCompressed();
+
+    set_zero(dg_dx_);
+
+    block_add(dg_dx_, 0, 0, dg_dx_cpr_);
+
+    // integral constraint
+    block_add(dg_dx_, qcon_B, tfvar_B, int_out1_.dF.middleCols(1, 1), w_scaling_);
+    block_add(dg_dx_, qcon_B, xvar_B, int_out1_.dF.middleCols(2, xvar_L), w_scaling_);
+    block_add(dg_dx_, qcon_B, uvar_B, int_out1_.dF.middleCols(2 + xvar_L, uvar_L), w_scaling_);
+    block_add_identity(dg_dx_, qcon_B, qvar_B, qvar_L, -w_scaling_);
+
+    dg_dx_.makeCompressed();
+    return dg_dx_;
+  }
+
   const Eigen::SparseMatrix<double> &
   d2g_dx2(const Eigen::Ref<const Eigen::VectorXd> x, const Eigen::Ref<const Eigen::VectorXd> lambda)
   {
@@ -467,43 +622,35 @@ auto nlpsol_to_ocpsol(const FlatOCPType auto & ocp, const MeshType auto & mesh,
   Eigen::MatrixXd X(ocp.Nx, N + 1);
   X = nlp_sol.x.segment(xvar_B, xvar_L).reshaped(ocp.Nx, xvar_L / ocp.Nx);
 
-  auto xfun = [t0 = t0, tf = tf, mesh = mesh, X = std::move(X)](double t) -> Eigen::Vector<double, Nx> {
-    return mesh.template eval<Eigen::Vector<double, Nx>>((t - t0) / (tf - t0), X.colwise(), 0, true);
-  };
+  auto xfun = PiecewisePolynomial<Nx>(mesh, X, t0, tf, true);
 
   // for these we repeat last point since there are no values for endpoint
 
   Eigen::MatrixXd U(ocp.Nu, N);
   U = nlp_sol.x.segment(uvar_B, uvar_L).reshaped(ocp.Nu, uvar_L / ocp.Nu);
 
-  auto ufun = [t0 = t0, tf = tf, mesh = mesh, U = std::move(U)](double t) -> Eigen::Vector<double, Nu> {
-    return mesh.template eval<Eigen::Vector<double, Nu>>((t - t0) / (tf - t0), U.colwise(), 0, false);
-  };
+  auto ufun = PiecewisePolynomial<Nu>(mesh, U, t0, tf, false);
 
   Eigen::MatrixXd Ldyn(ocp.Nx, N);
   Ldyn = nlp_sol.lambda.segment(dcon_B, dcon_L).reshaped(ocp.Nx, dcon_L / ocp.Nx);
 
-  auto ldfun = [t0 = t0, tf = tf, mesh = mesh, Ldyn = std::move(Ldyn)](double t) -> Eigen::Vector<double, Nx> {
-    return mesh.template eval<Eigen::Vector<double, Nx>>((t - t0) / (tf - t0), Ldyn.colwise(), 0, false);
-  };
+  auto ldfun = PiecewisePolynomial<Nx>(mesh, Ldyn, t0, tf, false);
 
   Eigen::MatrixXd Lcr(ocp.Ncr, N);
   Lcr = nlp_sol.lambda.segment(crcon_B, crcon_L).reshaped(ocp.Ncr, crcon_L / ocp.Ncr);
 
-  auto lcrfun = [t0 = t0, tf = tf, mesh = mesh, Lcr = std::move(Lcr)](double t) -> Eigen::Vector<double, Ncr> {
-    return mesh.template eval<Eigen::Vector<double, Ncr>>((t - t0) / (tf - t0), Lcr.colwise(), 0, false);
-  };
+  auto lcrfun = PiecewisePolynomial<Ncr>(mesh, Lcr, t0, tf, false);
 
   return OCPSolution<typename ocp_t::X, typename ocp_t::U, ocp_t::Nq, ocp_t::Ncr, ocp_t::Nce>{
     .t0         = t0,
     .tf         = tf,
     .Q          = std::move(Q),
-    .u          = std::move(ufun),
-    .x          = std::move(xfun),
+    .u          = std::move(ufun).into_callable(),
+    .x          = std::move(xfun).into_callable(),
     .lambda_q   = nlp_sol.lambda.segment(qcon_B, qcon_L),
     .lambda_ce  = nlp_sol.lambda.segment(cecon_B, cecon_L),
-    .lambda_dyn = std::move(ldfun),
-    .lambda_cr  = std::move(lcrfun),
+    .lambda_dyn = std::move(ldfun).into_callable(),
+    .lambda_cr  = std::move(lcrfun).into_callable(),
   };
 }
 
@@ -8,15 +8,47 @@
  */
 
 #include <Eigen/Core>
+#include <Eigen/LU>
+#include <Eigen/SparseLU>
 #include <smooth/diff.hpp>
 
+#include <vector>
+
 #include "collocation/mesh.hpp"
 #include "collocation/mesh_function.hpp"
+#include "collocation/piecewise_polynomial.hpp"
 #include "ocp.hpp"
 #include "qp.hpp"
 
 namespace smooth::feedback {
 
+/**
+ * @brief Quadratic program where the collocation dynamics constraints have been eliminated.
+ *
+ * The variables \f$ z = [x_0, \ldots, x_N, u_0, \ldots, u_{N-1}] \f$ of the full quadratic program from
+ * ocp_to_qp() are related to the reduced variables \f$ y = [x_0, u_0, \ldots, u_{N-1}] \f$ via
+ * \f$ z = T y + c \f$.
+ *
+ * @see ocp_to_qp_condensed(), qpsol_expand()
+ */
+struct CondensedQuadraticProgram
+{
+  /// @brief Reduced quadratic program in y with running and end constraints
+  QuadraticProgramSparse<double> qp;
+
+  /// @brief Map from reduced to full variables
+  Eigen::SparseMatrix<double> T;
+
+  /// @brief Offset from reduced to full variables
+  Eigen::VectorXd c;
+
+  /// @brief Full quadratic program (used to recover dynamics multipliers)
+  QuadraticProgramSparse<double> full;
+
+  /// @brief State dimension
+  Eigen::Index nx{0};
+};
+
 // \cond
 namespace detail {
 
@@ -399,6 +431,102 @@ void ocp_to_qp_update(
   ocp_to_qp_update_ce<DT>(qp, work, ocp, mesh, tf, xl_fun, ul_fun);
 }
 
+/**
+ * @brief Eliminate the collocation constraints from a quadratic program obtained via ocp_to_qp().
+ *
+ * In interval i with nodes \f$ M, \ldots, M + K_i \f$ the collocation constraints are
+ * \f$ G_0 x_M + G_1 [x_{M+1}, \ldots, x_{M+K_i}] + H [u_M, \ldots, u_{M+K_i-1}] = r \f$ with square
+ * \f$ G_1 \f$, so the states in the interval are eliminated by one dense factorization of \f$ G_1 \f$
+ * and substitution of the (already eliminated) interval start state. Only the column blocks of each interval are
+ * extracted, and the map from reduced to full variables is assembled directly as a sparse block-lower-triangular
+ * matrix.
+ *
+ * @tparam Nx state dimension
+ * @tparam Nu input dimension
+ */
+template<int Nx, int Nu>
+CondensedQuadraticProgram ocp_qp_condense(QuadraticProgramSparse<double> && full, const MeshType auto & mesh)
+{
+  const auto N = static_cast<Eigen::Index>(mesh.N_colloc());
+
+  const auto xvar_L = Nx * (N + 1);
+  const auto uvar_L = Nu * N;
+  const auto uvar_B = xvar_L;
+  const auto dcon_L = Nx * N;
+
+  const auto Nvar = xvar_L + uvar_L;
+  const auto Nred = Nx + uvar_L;
+  const auto Ncon = full.A.rows();
+
+  // z = T y + c where T is block-lower-triangular: states depend on x0 and preceding inputs
+  std::vector<Eigen::Triplet<double>> T_triplets;
+  for (auto i = 0; i < Nx; ++i) { T_triplets.emplace_back(i, i, 1); }
+  for (auto i = 0; i < uvar_L; ++i) { T_triplets.emplace_back(uvar_B + i, Nx + i, 1); }
+
+  CondensedQuadraticProgram ret;
+  ret.c.setZero(Nvar);
+
+  // interval start state as a function of [x0, u_0, ..., u_{M-1}]
+  Eigen::MatrixXd SM = Eigen::MatrixXd::Identity(Nx, Nx);
+
+  for (auto ival = 0ul, M = 0ul; ival < mesh.N_ivals(); M += mesh.N_colloc_ival(ival), ++ival) {
+    const auto Ki = static_cast<Eigen::Index>(mesh.N_colloc_ival(ival));
+    const auto r0 = static_cast<Eigen::Index>(M) * Nx;
+
+    // only the column blocks of the interval are non-zero
+    const Eigen::SparseMatrix<double, Eigen::RowMajor> Aival = full.A.middleRows(r0, Ki * Nx);
+
+    const Eigen::MatrixXd G0 = Aival.block(0, r0, Ki * Nx, Nx);
+    const Eigen::MatrixXd G1 = Aival.block(0, r0 + Nx, Ki * Nx, Ki * Nx);
+    const Eigen::MatrixXd H  = Aival.block(0, uvar_B + static_cast<Eigen::Index>(M) * Nu, Ki * Nx, Ki * Nu);
+
+    const Eigen::PartialPivLU<Eigen::MatrixXd> lu(G1);
+
+    const auto NcolM = SM.cols();
+
+    Eigen::MatrixXd rhs(Ki * Nx, NcolM + Ki * Nu);
+    rhs.leftCols(NcolM).noalias() = -G0 * SM;
+    rhs.rightCols(Ki * Nu)        = -H;
+
+    const Eigen::MatrixXd Sival = lu.solve(rhs);
+
+    ret.c.segment(r0 + Nx, Ki * Nx) = lu.solve(full.l.segment(r0, Ki * Nx) - G0 * ret.c.segment(r0, Nx));
+
+    for (auto col = 0; col < Sival.cols(); ++col) {
+      for (auto row = 0; row < Sival.rows(); ++row) {
+        if (Sival(row, col) != 0) { T_triplets.emplace_back(r0 + Nx + row, col, Sival(row, col)); }
+      }
+    }
+
+    SM = Sival.bottomRows(Nx);
+  }
+
+  ret.T.resize(Nvar, Nred);
+  ret.T.setFromTriplets(T_triplets.begin(), T_triplets.end());
+
+  // cost
+  const Eigen::SparseMatrix<double> P    = full.P.selfadjointView<Eigen::Upper>();
+  const Eigen::SparseMatrix<double> Pred = ret.T.transpose() * P * ret.T;
+
+  ret.qp.P = Pred.triangularView<Eigen::Upper>();
+  ret.qp.q = ret.T.transpose() * (P * ret.c + full.q);
+
+  // remaining constraints
+  const auto A_rest = full.A.bottomRows(Ncon - dcon_L);
+
+  ret.qp.A = A_rest * ret.T;
+  ret.qp.l = full.l.tail(Ncon - dcon_L) - A_rest * ret.c;
+  ret.qp.u = full.u.tail(Ncon - dcon_L) - A_rest * ret.c;
+
+  ret.qp.P.makeCompressed();
+  ret.qp.A.makeCompressed();
+
+  ret.full = std::move(full);
+  ret.nx   = Nx;
+
+  return ret;
+}
+
 }  // namespace detail
 // \endcond
 
@@ -434,6 +562,73 @@ ocp_to_qp(const OCPType auto & ocp, const MeshType auto & mesh, double tf, auto
   return qp;
 }
 
+/**
+ * @brief Formulate an optimal control problem as a quadratic program without dynamics constraints.
+ *
+ * Same as ocp_to_qp() except that the collocation dynamics constraints are eliminated interval by interval, so
+ * that the remaining quadratic program has only running and end constraints in the variables
+ * \f$ [x_0, u_0, \ldots, u_{N-1}] \f$.
+ *
+ * @param ocp input problem
+ * @param mesh time discretization
+ * @param tf time horizon
+ * @param xl_fun state linearization (must be differentiable w.r.t. time)
+ * @param ul_fun input linearization
+ *
+ * @return condensed quadratic program, use qpsol_expand() to obtain a solution of the full problem.
+ *
+ * @note The reduced problem is smaller and has no equality constraints, but its matrices are denser than those of
+ * the full problem since states depend on all preceding inputs. It is best suited for short horizons.
+ */
+template<diff::Type DT = diff::Type::Default>
+CondensedQuadraticProgram
+ocp_to_qp_condensed(const OCPType auto & ocp, const MeshType auto & mesh, double tf, auto && xl_fun, auto && ul_fun)
+{
+  using ocp_t = std::decay_t<decltype(ocp)>;
+
+  return detail::ocp_qp_condense<ocp_t::Nx, ocp_t::Nu>(ocp_to_qp<DT>(ocp, mesh, tf, xl_fun, ul_fun), mesh);
+}
+
+/**
+ * @brief Expand a solution of a condensed quadratic program into a solution of the full quadratic program.
+ *
+ * Multipliers of the eliminated dynamics constraints are recovered from the stationarity condition of the full
+ * problem.
+ *
+ * @param cqp condensed problem obtained via ocp_to_qp_condensed()
+ * @param qpsol solution to cqp.qp
+ *
+ * @return solution to cqp.full, which can be passed to qpsol_to_ocpsol().
+ */
+inline QPSolution<-1, -1, double>
+qpsol_expand(const CondensedQuadraticProgram & cqp, const QPSolution<-1, -1, double> & qpsol)
+{
+  const auto Ncon   = cqp.full.A.rows();
+  const auto Nrem   = cqp.qp.A.rows();
+  const auto dcon_L = Ncon - Nrem;
+
+  const Eigen::VectorXd z  = cqp.T * qpsol.primal + cqp.c;
+  const Eigen::VectorXd Pz = cqp.full.P.selfadjointView<Eigen::Upper>() * z;
+
+  // stationarity: P z + q + A_dyn' lambda_dyn + A_rem' lambda_rem = 0, restricted to eliminated states
+  const Eigen::VectorXd grad = Pz + cqp.full.q + cqp.full.A.bottomRows(Nrem).transpose() * qpsol.dual;
+
+  const Eigen::SparseMatrix<double> AdT = cqp.full.A.block(0, cqp.nx, dcon_L, dcon_L).transpose();
+  const Eigen::SparseLU<Eigen::SparseMatrix<double>> lu(AdT);
+
+  Eigen::VectorXd dual(Ncon);
+  dual.head(dcon_L) = lu.solve(-grad.segment(cqp.nx, dcon_L));
+  dual.tail(Nrem)   = qpsol.dual;
+
+  return {
+    .code      = qpsol.code,
+    .iter      = qpsol.iter,
+    .primal    = z,
+    .dual      = std::move(dual),
+    .objective = 0.5 * z.dot(Pz) + cqp.full.q.dot(z),
+  };
+}
+
 /**
  * @brief Convert QP solution to OCP solution
  *
@@ -478,16 +673,14 @@ auto qpsol_to_ocpsol(
   Eigen::MatrixXd Xmat = qpsol.primal.segment(xvar_B, xvar_L).reshaped(Nx, N + 1);
   Eigen::MatrixXd Umat = qpsol.primal.segment(uvar_B, uvar_L).reshaped(Nu, N);
 
-  auto xfun = [t0 = 0., tf = tf, mesh = mesh, Xmat = std::move(Xmat), xl_fun = std::forward<decltype(xl_fun)>(xl_fun)](
-                double t) -> X {
-    const auto tngnt = mesh.template eval<Eigen::Vector<double, Nx>>((t - t0) / (tf - t0), Xmat.colwise(), 0, true);
-    return rplus(xl_fun(t), tngnt);
+  auto xfun = [xpoly  = PiecewisePolynomial<Nx>(mesh, Xmat, 0., tf, true).into_callable(),
+               xl_fun = std::forward<decltype(xl_fun)>(xl_fun)](double t) mutable -> X {
+    return rplus(xl_fun(t), xpoly(t));
   };
 
-  auto ufun = [t0 = 0., tf = tf, mesh = mesh, Umat = std::move(Umat), ul_fun = std::forward<decltype(ul_fun)>(ul_fun)](
-                double t) -> U {
-    const auto tngnt = mesh.template eval<Eigen::Vector<double, Nu>>((t - t0) / (tf - t0), Umat.colwise(), 0, false);
-    return rplus(ul_fun(t), tngnt);
+  auto ufun = [upoly  = PiecewisePolynomial<Nu>(mesh, Umat, 0., tf, false).into_callable(),
+               ul_fun = std::forward<decltype(ul_fun)>(ul_fun)](double t) mutable -> U {
+    return rplus(ul_fun(t), upoly(t));
   };
 
   return OCPSolution<X, U, Nq, Nce, Ncr>{
@@ -2,7 +2,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <chrono>
+#include <functional>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
 #include <smooth/concepts/lie_group.hpp>
 #include <smooth/spline/spline.hpp>
@@ -20,11 +26,79 @@ struct PIDParams
   double windup_limit = std::numeric_limits<double>::infinity();
 };
 
+/**
+ * @brief Spline reference trajectory with windowed evaluation.
+ *
+ * Evaluating a smooth::Spline requires a search for the active segment, which is repeated for every evaluation.
+ * A SplineReference instead crops the spline into consecutive windows of equal length once at construction, and
+ * evaluates the window that contains the current time. The window is found by indexing, so an evaluation only
+ * searches the segments of one window, and does not allocate memory.
+ *
+ * smooth::Spline does not expose its segments, so the window length is a parameter. It should be chosen such that
+ * each window contains a small number of segments, e.g. the knot spacing of a spline fitted to uniformly sampled data.
+ * The windows replace the curve, i.e. the curve is not stored twice.
+ *
+ * @tparam K spline degree
+ * @tparam G LieGroup state space type
+ * @tparam T Time type
+ */
+template<int K, LieGroup G, Time T = double>
+class SplineReference
+{
+public:
+  /// Reference consists of position, velocity, and acceleration
+  using ReturnT = std::tuple<G, Tangent<G>, Tangent<G>>;
+
+  /**
+   * @brief Create a reference.
+   *
+   * @param t0 curve initial time s.t. the reference at time t is equal to c(t - t0)
+   * @param c curve
+   * @param window length of precomputed time windows
+   */
+  inline SplineReference(T t0, smooth::Spline<K, G> c, double window = 1.)
+      : t0_(std::move(t0)), window_(window)
+  {
+    const double t_max = c.t_max();
+    for (std::size_t i = 0; static_cast<double>(i) * window_ < t_max; ++i) {
+      const double ta = static_cast<double>(i) * window_;
+      wins_.push_back(c.crop(ta, std::min(ta + window_, t_max)));
+    }
+    if (wins_.empty()) { wins_.push_back(std::move(c)); }
+  }
+
+  /**
+   * @brief Evaluate reference at time t.
+   */
+  inline ReturnT operator()(T t) const
+  {
+    const double s = time_trait<T>::minus(t, t0_);
+
+    Tangent<G> vel, acc;
+
+    // window i covers [i * window, (i + 1) * window) and its cropped curve starts at time zero, times outside of
+    // the curve are evaluated in the first and last window
+    const std::size_t i = s < 0 ? 0 : std::min(static_cast<std::size_t>(s / window_), wins_.size() - 1);
+
+    G x = wins_[i](s - static_cast<double>(i) * window_, vel, acc);
+    return ReturnT(std::move(x), std::move(vel), std::move(acc));
+  }
+
+private:
+  T t0_;
+  double window_;
+
+  // cropped windows of the curve
+  std::vector<smooth::Spline<K, G>> wins_;
+};
+
 /**
  * @brief Proportional-Integral-Derivative controller for Lie groups.
  *
  * @tparam T Time type
  * @tparam G LieGroup state space type
+ * @tparam XDes desired trajectory type, callable as T -> (position, velocity, acceleration). Defaults to a
+ * std::function, use e.g. SplineReference to avoid the type erasure.
  *
  * This controller is designed for a system
  * \f[
@@ -34,8 +108,8 @@ struct PIDParams
  * \mathbf{u} \in \mathbb{R}^{\dim \mathbb{G}} \end{aligned} \f] i.e. the input is the body
  * acceleration.
  */
-template<Time T, LieGroup G>
-  requires(Dof<G> > 0)
+template<Time T, LieGroup G, typename XDes = std::function<std::tuple<G, Tangent<G>, Tangent<G>>(T)>>
+  requires(Dof<G> > 0 && std::is_invocable_r_v<std::tuple<G, Tangent<G>, Tangent<G>>, XDes &, T>)
 class PID
 {
 public:
@@ -51,6 +125,14 @@ public:
    * set to 0.
    */
   inline PID(const PIDParams & prm = PIDParams{}) noexcept : prm_(prm) {}
+
+  /**
+   * @brief Create a PID controller with a desired trajectory
+   *
+   * @param x_des desired trajectory (see set_xdes())
+   * @param prm parameters
+   */
+  inline explicit PID(XDes x_des, const PIDParams & prm = PIDParams{}) : prm_(prm), x_des_(std::move(x_des)) {}
   /// Default copy constructor
   PID(const PID &) = default;
   /// Default move constructor
@@ -136,10 +218,13 @@ public:
   /**
    * @brief Set desired trajectory as a smooth::Spline
    *
+   * If XDes is a SplineReference the curve is wrapped in one, otherwise the curve is evaluated directly.
+   *
    * @param c desired trajectory as a smooth::Spline
    * @param t0 curve initial time s.t. the desired position at time t is equal to c(t - t0)
    */
   template<int K>
+    requires(std::is_constructible_v<XDes, SplineReference<K, G, T>>)
   inline void set_xdes(T t0, const smooth::Spline<K, G> & c)
   {
     set_xdes(t0, smooth::Spline<K, G>(c));
@@ -149,13 +234,18 @@ public:
    * @brief Set desired trajectory as a smooth::Spline (rvalue version)
    */
   template<int K>
+    requires(std::is_constructible_v<XDes, SplineReference<K, G, T>>)
   inline void set_xdes(T t0, smooth::Spline<K, G> && c)
   {
-    set_xdes([t0 = std::move(t0), c = std::move(c)](T t) -> TrajectoryReturnT {
-      Tangent<G> vel, acc;
-      G x = c(time_trait<T>::minus(t, t0), vel, acc);
-      return TrajectoryReturnT(std::move(x), std::move(vel), std::move(acc));
-    });
+    if constexpr (std::is_same_v<XDes, std::function<TrajectoryReturnT(T)>>) {
+      set_xdes([t0 = std::move(t0), c = std::move(c)](T t) -> TrajectoryReturnT {
+        Tangent<G> vel, acc;
+        G x = c(time_trait<T>::minus(t, t0), vel, acc);
+        return TrajectoryReturnT(std::move(x), std::move(vel), std::move(acc));
+      });
+    } else {
+      set_xdes(XDes(SplineReference<K, G, T>(std::move(t0), std::move(c))));
+    }
   }
 
   /**
@@ -174,7 +264,7 @@ public:
    * \f]
    * where (x, v, a) is the (position, velocity, acceleration)-tuple returned by the trajectory.
    */
-  inline void set_xdes(const std::function<TrajectoryReturnT(T)> & f)
+  inline void set_xdes(const XDes & f)
   {
     auto f_copy = f;
     set_xdes(std::move(f_copy));
@@ -183,7 +273,7 @@ public:
   /**
    * @brief Set desired trajectory (rvalue version).
    */
-  inline void set_xdes(std::function<TrajectoryReturnT(T)> && f) { x_des_ = std::move(f); }
+  inline void set_xdes(XDes && f) { x_des_ = std::move(f); }
 
 private:
   PIDParams prm_;
@@ -198,9 +288,21 @@ private:
   Tangent<G> i_err_ = Tangent<G>::Zero();
 
   // desired trajectory
-  std::function<TrajectoryReturnT(T)> x_des_ = [](T) -> TrajectoryReturnT {
+  XDes x_des_ = default_xdes();
+
+  static TrajectoryReturnT zero_xdes(T)
+  {
     return TrajectoryReturnT(Identity<G>(), Tangent<G>::Zero(), Tangent<G>::Zero());
-  };
+  }
+
+  static XDes default_xdes()
+  {
+    if constexpr (std::is_constructible_v<XDes, TrajectoryReturnT (*)(T)>) {
+      return XDes(&zero_xdes);
+    } else {
+      return XDes{};
+    }
+  }
 };
 
 }  // namespace smooth::feedback
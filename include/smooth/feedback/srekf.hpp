@@ -0,0 +1,315 @@
+// Copyright (C) 2022 Petter Nilsson. MIT License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Square-root extended Kalman filter on Lie groups.
+ */
+
+#include <Eigen/Cholesky>
+#include <Eigen/QR>
+#include <boost/numeric/odeint.hpp>
+#include <smooth/compat/odeint.hpp>
+#include <smooth/concepts/lie_group.hpp>
+#include <smooth/diff.hpp>
+
+#include <cmath>
+#include <optional>
+#include <utility>
+
+#include "ekf.hpp"
+
+namespace smooth::feedback {
+
+// \cond
+namespace detail {
+
+/**
+ * @brief Square root of a positive semi-definite matrix.
+ *
+ * @param A positive semi-definite matrix (only upper triangular part is used)
+ * @return L s.t. \f$ A = L L^T \f$
+ */
+template<typename Derived>
+auto sqrt_psd(const Eigen::MatrixBase<Derived> & A)
+{
+  using Scalar = typename Derived::Scalar;
+  using Mat    = Eigen::Matrix<Scalar, Derived::RowsAtCompileTime, Derived::ColsAtCompileTime>;
+
+  // P A P' = L D L'  =>  A = (P' L D^{1/2}) (P' L D^{1/2})'
+  const auto ldlt = A.template selfadjointView<Eigen::Upper>().ldlt();
+  Mat L           = ldlt.matrixL();
+  L               = ldlt.transpositionsP().transpose() * L;
+  L *= ldlt.vectorD().cwiseMax(Scalar(0)).cwiseSqrt().asDiagonal();
+  return L;
+}
+
+/**
+ * @brief Square-root covariance time update.
+ *
+ * @param[in, out] S covariance square root, on input \f$ \Phi S \f$, on output lower triangular factor of
+ * \f$ \Phi S S^T \Phi^T + L_Q L_Q^T \f$.
+ * @param[in] LQ square root of discrete process noise covariance
+ */
+template<typename Scalar, int N>
+void srekf_time_update(Eigen::Matrix<Scalar, N, N> & S, const Eigen::Matrix<Scalar, N, N> & LQ)
+{
+  // pre-array [S LQ]' = Q R  =>  [S LQ] [S LQ]' = R' R
+  Eigen::Matrix<Scalar, 2 * N, N> pre;
+  pre.template topRows<N>()    = S.transpose();
+  pre.template bottomRows<N>() = LQ.transpose();
+
+  const Eigen::HouseholderQR<Eigen::Ref<Eigen::Matrix<Scalar, 2 * N, N>>> qr(pre);
+
+  S = qr.matrixQR().template topRows<N>().template triangularView<Eigen::Upper>().transpose();
+}
+
+/**
+ * @brief Square-root covariance measurement update.
+ *
+ * Triangularizes the pre-array
+ * \f[
+ *   \begin{bmatrix} S_R & H S \\ 0 & S \end{bmatrix} \Theta
+ *   = \begin{bmatrix} S_e & 0 \\ \bar K & S^+ \end{bmatrix}
+ * \f]
+ * where \f$ S_e S_e^T = H P H^T + R \f$ is the innovation covariance and \f$ K = \bar K S_e^{-1} \f$ is the
+ * Kalman gain.
+ *
+ * @param[in, out] S covariance square root, updated in place
+ * @param[in] H measurement Jacobian
+ * @param[in] SR square root of measurement covariance
+ *
+ * @return Kalman gain \f$ K \f$
+ */
+template<typename Scalar, int N, int Ny>
+Eigen::Matrix<Scalar, N, Ny> srekf_meas_update(
+  Eigen::Matrix<Scalar, N, N> & S, const Eigen::Matrix<Scalar, Ny, N> & H, const Eigen::Matrix<Scalar, Ny, Ny> & SR)
+{
+  // transposed pre-array, triangularized with QR: pre' = Q R  =>  pre Q = R'
+  Eigen::Matrix<Scalar, N + Ny, N + Ny> pre;
+  pre.template topLeftCorner<Ny, Ny>() = SR.transpose();
+  pre.template topRightCorner<Ny, N>().setZero();
+  pre.template bottomLeftCorner<N, Ny>().noalias() = (H * S).transpose();
+  pre.template bottomRightCorner<N, N>()           = S.transpose();
+
+  const Eigen::HouseholderQR<Eigen::Ref<Eigen::Matrix<Scalar, N + Ny, N + Ny>>> qr(pre);
+
+  // post-array is R' = [Se 0; Kbar Splus]
+  const auto & R = qr.matrixQR();
+
+  S = R.template bottomRightCorner<N, N>().template triangularView<Eigen::Upper>().transpose();
+
+  // K Se = Kbar  <=>  Se' K' = Kbar'
+  return R.template topLeftCorner<Ny, Ny>()
+    .template triangularView<Eigen::Upper>()
+    .solve(R.template topRightCorner<Ny, N>())
+    .transpose();
+}
+
+}  // namespace detail
+// \endcond
+
+/**
+ * @brief Square-root extended Kalman filter on Lie groups.
+ *
+ * Same interface as EKF, but instead of the covariance \f$ P \f$ the filter propagates a square root \f$ S \f$
+ * s.t. \f$ P = S S^T \f$. Time and measurement updates are computed with orthogonal (QR) transformations of
+ * pre-arrays, which keeps the covariance symmetric and positive semi-definite by construction and roughly
+ * doubles the numerical precision compared to the conventional covariance form.
+ *
+ * @tparam G \p smooth::LieGroup type.
+ * @tparam DiffType \p smooth::diff::Type method for calculating derivatives.
+ * @tparam Stpr \p boost::numeric::odeint templated stepper type for the state (\p euler / \p runge_kutta4 /
+ * ...). Defaults to \p euler.
+ */
+template<
+  LieGroup G,
+  diff::Type DiffType                 = diff::Type::Default,
+  template<typename...> typename Stpr = boost::numeric::odeint::euler>
+  requires(Dof<G> > 0)
+class SquareRootEKF
+{
+public:
+  //! Covariance type.
+  using CovT = Eigen::Matrix<Scalar<G>, Dof<G>, Dof<G>>;
+
+  /**
+   * @brief Reset the state of the filter.
+   *
+   * @param g filter value
+   * @param P filter covariance (only upper triangular part is used)
+   */
+  void reset(const G & g, const CovT & P)
+  {
+    g_hat_ = g;
+    S_     = detail::sqrt_psd(P);
+  }
+
+  /**
+   * @brief Reset the state of the filter from a covariance square root.
+   *
+   * @param g filter value
+   * @param S covariance square root s.t. \f$ P = S S^T \f$
+   */
+  void reset_sqrt(const G & g, const CovT & S)
+  {
+    g_hat_ = g;
+    S_     = S;
+  }
+
+  /**
+   * @brief Access filter state estimate.
+   */
+  G estimate() const { return g_hat_; }
+
+  /**
+   * @brief Access filter covariance.
+   */
+  CovT covariance() const { return S_ * S_.transpose(); }
+
+  /**
+   * @brief Access filter covariance square root \f$ S \f$ s.t. \f$ P = S S^T \f$.
+   *
+   * @note S is lower triangular after a call to predict() or update().
+   */
+  const CovT & sqrt_covariance() const { return S_; }
+
+  /**
+   * @brief Propagate filter through dynamics \f$ \mathrm{d}^r x_t = f(t, x) \f$ with covariance
+   * \f$Q\f$ over a time interval \f$ [0, \tau] \f$.
+   *
+   * In every step of length \f$ h \f$ the dynamics are linearized as \f$ A = -\mathrm{ad}_{f} + \mathrm{d}^r f_x \f$
+   * and the covariance square root is updated with the transition matrix \f$ \Phi = \exp(A h) \f$ (approximated to
+   * fourth order) and the process noise \f$ Q h \f$.
+   *
+   * @param f right-hand side \f$ f : \mathbb{R} \times \mathbb{G} \rightarrow \mathbb{R}^{\dim
+   * \mathfrak{g}} \f$ of the dynamics. The time type must be the scalar type of G.
+   * @param Q process covariance (size \f$ \dim \mathfrak{g} \times \dim \mathfrak{g} \f$)
+   * @param tau amount of time to propagate
+   * @param dt maximal step size (defaults to \p tau, i.e. one step)
+   *
+   * @note See EKF::predict() for units of Q.
+   *
+   * @note Only the upper triangular part of Q is used.
+   */
+  template<typename F, typename QDer>
+  void predict(F && f, const Eigen::MatrixBase<QDer> & Q, Scalar<G> tau, std::optional<Scalar<G>> dt = {})
+  {
+    const auto state_ode = [&f](const G & g, Tangent<G> & dg, Scalar<G> t) { dg = f(t, g); };
+
+    const CovT LQ = detail::sqrt_psd(Q);
+
+    const auto cov_step = [this, &f, &LQ](Scalar<G> t, Scalar<G> h) {
+      const auto f_x      = [&f, &t]<typename _T>(const CastT<_T, G> & x) -> Tangent<CastT<_T, G>> { return f(t, x); };
+      const auto [fv, dr] = diff::dr<1, DiffType>(f_x, wrt(g_hat_));
+      const CovT Ah       = h * (-ad<G>(fv) + dr);
+
+      // fourth-order approximation of exp(A h) in Horner form
+      CovT Phi = CovT::Identity() + Ah / 4;
+      Phi      = CovT::Identity() + Ah * Phi / 3;
+      Phi      = CovT::Identity() + Ah * Phi / 2;
+      Phi      = CovT::Identity() + Ah * Phi;
+
+      S_ = Phi * S_;
+      detail::srekf_time_update<Scalar<G>, Dof<G>>(S_, CovT(std::sqrt(h) * LQ));
+    };
+
+    Scalar<G> t          = 0;
+    const Scalar<G> dt_v = dt.value_or(2 * tau);
+    while (t + dt_v < tau) {
+      // step covariance first since it depends on g_hat_
+      cov_step(t, dt_v);
+      sst_.do_step(state_ode, g_hat_, t, dt_v);
+      t += dt_v;
+    }
+
+    // last step up to time t
+    cov_step(t, tau - t);
+    sst_.do_step(state_ode, g_hat_, t, tau - t);
+  }
+
+  /**
+   * @brief Propagate filter through dynamics \f$ \mathrm{d}^r x_t = f(t, x) \f$ with covariance
+   * \f$Q\f$ over a time interval \f$ [0, \tau] \f$ using a single linearization.
+   *
+   * Square-root version of EKF::predict_discrete(): the covariance square root is updated from the cached
+   * transition \f$ \Phi \f$ and a cached square root of the discrete process noise \f$ Q_d \f$.
+   *
+   * @param f right-hand side of the dynamics (see predict())
+   * @param Q process covariance (see predict())
+   * @param tau amount of time to propagate
+   * @param dt maximal ODE solver step size for the state (defaults to \p tau, i.e. one step)
+   *
+   * @note Only the upper triangular part of Q is used.
+   */
+  template<typename F, typename QDer>
+  void predict_discrete(F && f, const Eigen::MatrixBase<QDer> & Q, Scalar<G> tau, std::optional<Scalar<G>> dt = {})
+  {
+    const auto state_ode = [&f](const G & g, Tangent<G> & dg, Scalar<G> t) { dg = f(t, g); };
+
+    const auto f_x = [&f]<typename _T>(const CastT<_T, G> & x) -> Tangent<CastT<_T, G>> {
+      return f(Scalar<G>(0), x);
+    };
+    const auto [fv, dr] = diff::dr<1, DiffType>(f_x, wrt(g_hat_));
+
+    if (trans_.update(-ad<G>(fv) + dr, Q, tau)) { LQd_ = detail::sqrt_psd(trans_.Qd); }
+
+    S_ = trans_.Phi * S_;
+    detail::srekf_time_update<Scalar<G>, Dof<G>>(S_, LQd_);
+
+    Scalar<G> t          = 0;
+    const Scalar<G> dt_v = dt.value_or(2 * tau);
+    while (t + dt_v < tau) {
+      sst_.do_step(state_ode, g_hat_, t, dt_v);
+      t += dt_v;
+    }
+    sst_.do_step(state_ode, g_hat_, t, tau - t);
+  }
+
+  /**
+   * @brief Update filter with a measurement \f$y = h(x) + w\f$ where \f$w \sim \mathcal N(0, R)\f$.
+   *
+   * @param h measurement function \f$ h : \mathbb{G} \rightarrow \mathbb{Y} \f$
+   * @param y measurement value \f$ y \in \mathbb{Y} \f$
+   * @param R measurement covariance (size \f$ \dim \mathbb{Y} \times \dim \mathbb{Y} \f$)
+   *
+   * @note The function h must be differentiable using the desired method.
+   *
+   * @note Only the upper triangular part of \f$R\f$ is used
+   */
+  template<typename F, typename RDev, Manifold Y = std::invoke_result_t<F, G>>
+  void update(F && h, const Y & y, const Eigen::MatrixBase<RDev> & R)
+  {
+    const auto [hval, H] = diff::dr<1, DiffType>(h, wrt(g_hat_));
+
+    using Result = std::decay_t<decltype(hval)>;
+
+    static_assert(Manifold<Result>, "h(x) is not a Manifold");
+
+    static constexpr Eigen::Index Ny = Dof<Result>;
+
+    static_assert(Ny > 0, "h(x) must be statically sized");
+
+    using RT = Eigen::Matrix<Scalar<G>, Ny, Ny>;
+
+    const Eigen::Matrix<Scalar<G>, Dof<G>, Ny> K =
+      detail::srekf_meas_update<Scalar<G>, Dof<G>, Ny>(S_, H, RT(detail::sqrt_psd(R)));
+
+    g_hat_ += K * (y - hval);
+  }
+
+private:
+  // filter estimate and covariance square root
+  G g_hat_ = Default<G>();
+  CovT S_  = CovT::Identity();
+
+  // stepper for numerical ODE solution of state
+  Stpr<G, Scalar<G>, Tangent<G>, Scalar<G>, boost::numeric::odeint::vector_space_algebra> sst_{};
+
+  // cached discretization and discrete noise square root for predict_discrete()
+  detail::DiscreteTransition<Scalar<G>, Dof<G>> trans_{};
+  CovT LQd_ = CovT::Zero();
+};
+
+}  // namespace smooth::feedback
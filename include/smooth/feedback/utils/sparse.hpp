@@ -7,11 +7,18 @@
  * @brief Sparse matrix utilities.
  */
 
+#include <algorithm>
+#include <cmath>
 #include <numeric>
 #include <optional>
+#include <span>
+#include <vector>
 
+#include <Eigen/Core>
 #include <Eigen/Sparse>
 
+#include "thread_pool.hpp"
+
 namespace smooth::feedback {
 
 /**
@@ -194,6 +201,146 @@ Eigen::MatrixX<typename Mat::Scalar> mark_explicit_zeros(const Mat & mat)
   return ret;
 }
 
+/**
+ * @brief Curtis-Powell-Reid column coloring of a sparsity pattern.
+ *
+ * Columns are greedily assigned the smallest color not used by any column that shares a row with it. Columns with the
+ * same color are structurally orthogonal, so a Jacobian with this sparsity pattern can be estimated from one
+ * perturbation per color.
+ *
+ * @param pattern sparsity pattern (values are ignored)
+ * @return pair (number of colors, color of each column)
+ *
+ * @see fd_jacobian_colored()
+ */
+template<int Options>
+std::pair<Eigen::Index, Eigen::VectorXi> cpr_coloring(const Eigen::SparseMatrix<double, Options> & pattern)
+{
+  const Eigen::SparseMatrix<double, Eigen::ColMajor> C = pattern;
+  const Eigen::SparseMatrix<double, Eigen::RowMajor> R = pattern;
+
+  Eigen::VectorXi colors = Eigen::VectorXi::Constant(C.cols(), -1);
+  Eigen::VectorXi forbidden = Eigen::VectorXi::Constant(C.cols() + 1, -1);  // forbidden(c) == j if c taken for j
+
+  Eigen::Index n_colors = 0;
+  for (auto j = 0; j < C.outerSize(); ++j) {
+    for (Eigen::SparseMatrix<double, Eigen::ColMajor>::InnerIterator itc(C, j); itc; ++itc) {
+      for (Eigen::SparseMatrix<double, Eigen::RowMajor>::InnerIterator itr(R, itc.row()); itr; ++itr) {
+        if (colors(itr.col()) >= 0) { forbidden(colors(itr.col())) = j; }
+      }
+    }
+    int color = 0;
+    while (forbidden(color) == j) { ++color; }
+    colors(j) = color;
+    n_colors  = std::max<Eigen::Index>(n_colors, color + 1);
+  }
+
+  return {n_colors, std::move(colors)};
+}
+
+/**
+ * @brief Jacobian via compressed forward differences with one function object per thread.
+ *
+ * All columns of the same color are perturbed simultaneously, so f is evaluated once per color (plus once at x).
+ * Colors are distributed over the threads of pool, and thread i only calls fs[i]. Both the function objects and
+ * the pool can therefore be created once and re-used between calls.
+ *
+ * @param fs functions \f$ \mathbb{R}^n \rightarrow \mathbb{R}^m \f$, one per thread (must be non-empty)
+ * @param x point of evaluation
+ * @param coloring column coloring of J's sparsity pattern (from cpr_coloring())
+ * @param[in, out] J Jacobian: structure must be allocated and compressed, values are overwritten
+ * @param pool threads to distribute colors over (evaluation is serial if nullptr)
+ */
+template<typename F, std::size_t Extent>
+void fd_jacobian_colored(
+  std::span<F, Extent> fs,
+  const Eigen::Ref<const Eigen::VectorXd> x,
+  const std::pair<Eigen::Index, Eigen::VectorXi> & coloring,
+  Eigen::SparseMatrix<double> & J,
+  ThreadPool * pool = nullptr)
+{
+  const auto & [n_colors, colors] = coloring;
+
+  assert(!fs.empty());
+  assert(J.isCompressed());
+  assert(J.cols() == x.size());
+  assert(colors.size() == x.size());
+
+  const Eigen::VectorXd f0 = fs[0](x);
+  const Eigen::VectorXd h  = std::sqrt(Eigen::NumTraits<double>::epsilon()) * x.cwiseAbs().cwiseMax(1.);
+
+  // sort columns by color
+  std::vector<Eigen::Index> col_beg(n_colors + 1, 0), cols(x.size());
+  for (auto j = 0; j < x.size(); ++j) { ++col_beg[colors(j) + 1]; }
+  std::partial_sum(col_beg.begin(), col_beg.end(), col_beg.begin());
+  {
+    std::vector<Eigen::Index> pos(col_beg.begin(), col_beg.end() - 1);
+    for (auto j = 0; j < x.size(); ++j) { cols[pos[colors(j)]++] = j; }
+  }
+
+  const auto n_threads =
+    std::min<std::size_t>(pool ? std::min(pool->size(), fs.size()) : 1, static_cast<std::size_t>(n_colors));
+
+  // each color writes distinct columns of J, so threads never write the same coefficient
+  const auto work = [&](std::size_t thread) {
+    if (thread >= n_threads) { return; }
+    auto & fw          = fs[thread];
+    Eigen::VectorXd xp = x;
+    for (auto c = static_cast<Eigen::Index>(thread); c < n_colors; c += static_cast<Eigen::Index>(n_threads)) {
+      for (auto k = col_beg[c]; k < col_beg[c + 1]; ++k) { xp(cols[k]) += h(cols[k]); }
+      const auto & fp = fw(xp);
+      for (auto k = col_beg[c]; k < col_beg[c + 1]; ++k) {
+        const auto j = cols[k];
+        for (Eigen::SparseMatrix<double>::InnerIterator it(J, j); it; ++it) {
+          it.valueRef() = (fp(it.row()) - f0(it.row())) / h(j);
+        }
+        xp(j) = x(j);
+      }
+    }
+  };
+
+  if (n_threads > 1) {
+    pool->run(work);
+  } else {
+    work(0);
+  }
+}
+
+/**
+ * @brief Jacobian via compressed forward differences.
+ *
+ * Colors are distributed over the threads of pool, where each additional thread operates on a copy of f.
+ *
+ * @param f function \f$ \mathbb{R}^n \rightarrow \mathbb{R}^m \f$ (copy-constructible if pool is used)
+ * @param x point of evaluation
+ * @param coloring column coloring of J's sparsity pattern (from cpr_coloring())
+ * @param[in, out] J Jacobian: structure must be allocated and compressed, values are overwritten
+ * @param pool threads to distribute colors over (evaluation is serial if nullptr)
+ *
+ * @see fd_jacobian_colored(std::span<F, Extent>, ...) to avoid copying f in every call.
+ */
+template<typename F>
+  requires(std::is_invocable_v<std::decay_t<F> &, const Eigen::Ref<const Eigen::VectorXd>>)
+void fd_jacobian_colored(
+  F && f,
+  const Eigen::Ref<const Eigen::VectorXd> x,
+  const std::pair<Eigen::Index, Eigen::VectorXi> & coloring,
+  Eigen::SparseMatrix<double> & J,
+  ThreadPool * pool = nullptr)
+{
+  const auto n_threads = std::min<std::size_t>(pool ? pool->size() : 1, static_cast<std::size_t>(coloring.first));
+
+  if constexpr (std::is_copy_constructible_v<std::decay_t<F>>) {
+    if (n_threads > 1) {
+      std::vector<std::decay_t<F>> fs(n_threads, f);
+      fd_jacobian_colored(std::span(fs), x, coloring, J, pool);
+      return;
+    }
+  }
+
+  fd_jacobian_colored(std::span(&f, 1), x, coloring, J);
+}
+
 /**
  * @brief (Right) Hessian of composed function \f$ (f \circ g)(x) \f$.
  *
@@ -0,0 +1,121 @@
+// Copyright (C) 2022 Petter Nilsson. MIT License.
+
+#pragma once
+
+/**
+ * @file
+ * @brief Persistent worker threads.
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace smooth::feedback {
+
+/**
+ * @brief Fixed set of worker threads that are started once and re-used for every call to run().
+ *
+ * The calling thread acts as thread 0, so a pool of size n starts n - 1 worker threads.
+ *
+ * @note run() is not re-entrant: a pool must not be used from more than one thread at a time.
+ */
+class ThreadPool
+{
+public:
+  /**
+   * @brief Start worker threads.
+   *
+   * @param n_threads total number of threads (including the calling thread)
+   */
+  explicit ThreadPool(std::size_t n_threads = 1) : n_threads_(std::max<std::size_t>(n_threads, 1))
+  {
+    workers_.reserve(n_threads_ - 1);
+    for (auto th = 1u; th < n_threads_; ++th) { workers_.emplace_back(&ThreadPool::worker_loop, this, th); }
+  }
+
+  /// @brief Worker threads refer to this instance, so it can not be copied
+  ThreadPool(const ThreadPool &) = delete;
+  /// @brief Worker threads refer to this instance, so it can not be moved
+  ThreadPool(ThreadPool &&) = delete;
+  /// @brief Worker threads refer to this instance, so it can not be copied
+  ThreadPool & operator=(const ThreadPool &) = delete;
+  /// @brief Worker threads refer to this instance, so it can not be moved
+  ThreadPool & operator=(ThreadPool &&) = delete;
+
+  /// @brief Stop worker threads
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard lock(mtx_);
+      stop_ = true;
+    }
+    cv_start_.notify_all();
+    for (auto & worker : workers_) { worker.join(); }
+  }
+
+  /// @brief Total number of threads (including the calling thread)
+  std::size_t size() const { return n_threads_; }
+
+  /**
+   * @brief Call work(th) for th = 0, ..., size() - 1 concurrently and wait for all calls to return.
+   *
+   * @param work callable with signature void(std::size_t)
+   */
+  void run(const auto & work)
+  {
+    if (workers_.empty()) {
+      work(std::size_t{0});
+      return;
+    }
+
+    // capture by pointer to avoid allocation in std::function
+    job_ = [work_p = &work](std::size_t th) { (*work_p)(th); };
+
+    {
+      std::lock_guard lock(mtx_);
+      n_busy_ = workers_.size();
+      ++generation_;
+    }
+    cv_start_.notify_all();
+
+    work(std::size_t{0});
+
+    std::unique_lock lock(mtx_);
+    cv_done_.wait(lock, [this] { return n_busy_ == 0; });
+    job_ = nullptr;
+  }
+
+private:
+  /// @brief Wait for jobs and run them as thread th
+  void worker_loop(std::size_t th)
+  {
+    std::size_t generation = 0;
+    std::unique_lock lock(mtx_);
+    while (true) {
+      cv_start_.wait(lock, [&] { return stop_ || generation_ != generation; });
+      if (stop_) { return; }
+      generation = generation_;
+
+      lock.unlock();
+      job_(th);
+      lock.lock();
+
+      if (--n_busy_ == 0) { cv_done_.notify_one(); }
+    }
+  }
+
+  std::size_t n_threads_;
+  std::vector<std::thread> workers_;
+  std::mutex mtx_;
+  std::condition_variable cv_start_, cv_done_;
+  std::function<void(std::size_t)> job_;
+  std::size_t generation_{0};
+  std::size_t n_busy_{0};
+  bool stop_{false};
+};
+
+}  // namespace smooth::feedback
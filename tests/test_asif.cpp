@@ -94,6 +94,120 @@ TEST(Asif, Basic)
   ASSERT_EQ(qp.u(Nh * K + niq), std::numeric_limits<double>::infinity());
 }
 
+TEST(Asif, Integrators)
+{
+  const auto f = []<typename T>(const G<T> &, const U1<T> & u) -> Eigen::Matrix<T, 3, 1> {
+    return Eigen::Matrix<T, 3, 1>(u(0), T(0), u(1));
+  };
+
+  const auto h = []<typename T>(T, const G<T> & g) -> Eigen::Matrix<T, 2, 1> { return g.r2(); };
+
+  // state-dependent backup controller
+  const auto bu = []<typename T>(T, const G<T> & g) -> Eigen::Matrix<T, 2, 1> {
+    const Eigen::Matrix<T, 3, 1> v = g.log();
+    return Eigen::Matrix<T, 2, 1>(T(0.5) - T(0.2) * v(0), -v(2));
+  };
+
+  smooth::feedback::ASIFProblem<smooth::SE2d, Eigen::Vector2d> pbm{
+    .T     = 2,
+    .x0    = smooth::SE2d(smooth::SO2d(0.5), Eigen::Vector2d(1, -1)),
+    .u_des = Eigen::Vector2d{0.5, 0.5},
+  };
+
+  const auto qp_ref = smooth::feedback::asif_to_qp<G<double>, U1<double>>(pbm, {.K = 4, .dt = 1e-4}, f, h, bu);
+  const auto qp_eu  = smooth::feedback::asif_to_qp<G<double>, U1<double>>(pbm, {.K = 4, .dt = 0.1}, f, h, bu);
+  const auto qp_rk  = smooth::feedback::asif_to_qp<G<double>, U1<double>>(
+    pbm, {.K = 4, .dt = 0.1, .integrator = smooth::feedback::ASIFIntegrator::RK4}, f, h, bu);
+
+  const double err_eu = (qp_eu.A - qp_ref.A).norm() + (qp_eu.l - qp_ref.l).norm();
+  const double err_rk = (qp_rk.A - qp_ref.A).norm() + (qp_rk.l - qp_ref.l).norm();
+
+  ASSERT_LE(err_rk, 1e-2);
+  ASSERT_LT(err_rk, err_eu);
+}
+
+TEST(Asif, RK4Order)
+{
+  const auto f = []<typename T>(const G<T> &, const U1<T> & u) -> Eigen::Matrix<T, 3, 1> {
+    return Eigen::Matrix<T, 3, 1>(u(0), T(0), u(1));
+  };
+
+  // backup controller that makes the closed loop rotate and translate
+  const auto bu = []<typename T>(T, const G<T> & g) -> Eigen::Matrix<T, 2, 1> {
+    const Eigen::Matrix<T, 3, 1> v = g.log();
+    return Eigen::Matrix<T, 2, 1>(T(0.5) - T(0.2) * v(1), T(0.8) - v(2));
+  };
+
+  const smooth::SE2d x0(smooth::SO2d(0.5), Eigen::Vector2d(1, -1));
+
+  const auto integrate = [&](const double h) {
+    smooth::SE2d x    = x0;
+    Eigen::Matrix3d S = Eigen::Matrix3d::Identity();
+    for (auto i = 0; i < std::lround(2 / h); ++i) {
+      smooth::feedback::detail::asif_rk4_step<G<double>, smooth::diff::Type::Default>(f, bu, x, S, i * h, h);
+    }
+    return std::make_pair(x, S);
+  };
+
+  const auto [x_ref, S_ref] = integrate(1e-3);
+  const auto [x_1, S_1]     = integrate(0.2);
+  const auto [x_2, S_2]     = integrate(0.1);
+
+  // halving the step size reduces the error by 2^4 for a fourth-order method (2^2 without dexpinv correction)
+  ASSERT_GE(smooth::rminus(x_1, x_ref).norm() / smooth::rminus(x_2, x_ref).norm(), 10);
+  ASSERT_GE((S_1 - S_ref).norm() / (S_2 - S_ref).norm(), 10);
+}
+
+TEST(Asif, BackupReuse)
+{
+  const auto f = []<typename T>(const G<T> &, const U1<T> & u) -> Eigen::Matrix<T, 3, 1> {
+    return Eigen::Matrix<T, 3, 1>(u(0), T(0), u(1));
+  };
+
+  const auto h = []<typename T>(T, const G<T> & g) -> Eigen::Matrix<T, 2, 1> { return g.r2(); };
+
+  const auto bu = []<typename T>(T, const G<T> & g) -> Eigen::Matrix<T, 2, 1> {
+    const Eigen::Matrix<T, 3, 1> v = g.log();
+    return Eigen::Matrix<T, 2, 1>(T(0.5) - T(0.2) * v(0), -v(2));
+  };
+
+  smooth::feedback::ASIFProblem<smooth::SE2d, Eigen::Vector2d> pbm{
+    .T     = 2,
+    .x0    = smooth::SE2d(smooth::SO2d(0.5), Eigen::Vector2d(1, -1)),
+    .u_des = Eigen::Vector2d{0.5, 0.5},
+  };
+
+  const smooth::feedback::ASIFtoQPParams prm{.K = 4, .dt = 0.01, .backup_reuse_threshold = 0.1};
+
+  smooth::feedback::ASIFBackupTrajectory<G<double>> backup;
+  smooth::feedback::QuadraticProgram<-1, 3, double> qp;
+  smooth::feedback::asif_to_qp_allocate<G<double>, U1<double>>(qp, prm.K, 0, 2);
+
+  // first call integrates and stores trajectory
+  smooth::feedback::asif_to_qp_update<G<double>, U1<double>>(qp, pbm, prm, f, h, bu, &backup);
+  ASSERT_EQ(backup.xs.size(), prm.K);
+  ASSERT_EQ(backup.n_reuse, 0u);
+  ASSERT_TRUE(backup.valid);
+
+  // nearby state re-uses trajectory
+  pbm.x0 = smooth::rplus(pbm.x0, Eigen::Vector3d(0.01, -0.01, 0.02));
+  smooth::feedback::asif_to_qp_update<G<double>, U1<double>>(qp, pbm, prm, f, h, bu, &backup);
+  ASSERT_EQ(backup.n_reuse, 1u);
+
+  const auto qp_ref = smooth::feedback::asif_to_qp<G<double>, U1<double>>(pbm, prm, f, h, bu);
+  ASSERT_LE((qp.A - qp_ref.A).norm() + (qp.l - qp_ref.l).norm(), 1e-2);
+
+  // state far away triggers re-integration
+  pbm.x0 = smooth::rplus(pbm.x0, Eigen::Vector3d(0.5, 0, 0));
+  smooth::feedback::asif_to_qp_update<G<double>, U1<double>>(qp, pbm, prm, f, h, bu, &backup);
+  ASSERT_EQ(backup.n_reuse, 0u);
+  ASSERT_TRUE(backup.x0.isApprox(pbm.x0));
+
+  const auto qp_ref2 = smooth::feedback::asif_to_qp<G<double>, U1<double>>(pbm, prm, f, h, bu);
+  ASSERT_TRUE(qp.A.isApprox(qp_ref2.A));
+  ASSERT_TRUE(qp.l.isApprox(qp_ref2.l));
+}
+
 template<typename T>
 using X = smooth::SO3<T>;
 
@@ -127,3 +241,207 @@ TEST(Asif, Filter)
 
   ASSERT_EQ(code, smooth::feedback::QPSolutionStatus::Optimal);
 }
+
+TEST(Asif, FilterStatic)
+{
+  auto f  = []<typename T>(const X<T> &, const U<T> & u) -> smooth::Tangent<X<T>> { return u; };
+  auto h  = []<typename T>(T, const X<T> & g) -> Eigen::Vector3<T> { return g.log(); };
+  auto bu = []<typename T>(T, const X<T> &) -> U<T> { return U<T>(1, 1, 1); };
+
+  static constexpr std::size_t K  = 10;
+  static constexpr std::size_t nh = 3;
+
+  smooth::feedback::ASIFilterParams<U<double>> prm{
+    .nh   = nh,
+    .asif = {.K = K},
+    .qp   = {.polish = false},
+  };
+
+  smooth::feedback::ASIFilter<X<double>, U<double>, decltype(f)> asif_dyn(f, prm);
+  smooth::feedback::ASIFilter<X<double>, U<double>, decltype(f), smooth::diff::Type::Default, K * nh + 1> asif_st(
+    f, prm);
+
+  smooth::SO3d g           = smooth::SO3d::Random();
+  Eigen::Vector3<double> u = Eigen::Vector3d::Zero();
+
+  // repeated calls re-use the solver and warmstart
+  for (auto i = 0u; i < 3; ++i) {
+    const auto [u_dyn, code_dyn] = asif_dyn(g, u, h, bu);
+    const auto [u_st, code_st]   = asif_st(g, u, h, bu);
+
+    ASSERT_EQ(code_dyn, smooth::feedback::QPSolutionStatus::Optimal);
+    ASSERT_EQ(code_st, smooth::feedback::QPSolutionStatus::Optimal);
+    ASSERT_LE((u_st - u_dyn).cwiseAbs().maxCoeff(), 1e-4);
+
+    g = g * smooth::SO3d::exp(0.01 * u_st);
+  }
+}
+
+TEST(Asif, FilterScreened)
+{
+  auto f  = []<typename T>(const X<T> &, const U<T> & u) -> smooth::Tangent<X<T>> { return u; };
+  auto h  = []<typename T>(T, const X<T> & g) -> Eigen::Vector3<T> { return g.log(); };
+  auto bu = []<typename T>(T, const X<T> &) -> U<T> { return U<T>(1, 1, 1); };
+
+  smooth::feedback::ASIFilterParams<U<double>> prm{
+    .nh   = 3,
+    .asif = {.K = 10},
+    .qp   = {.polish = false},
+  };
+
+  using ASIF = smooth::feedback::ASIFilter<X<double>, U<double>, decltype(f)>;
+
+  ASIF asif(f, prm);
+
+  // screening with room for all barrier constraints
+  prm.screen_factor   = 1;
+  prm.screen_max_rows = 30;
+  ASIF asif_scr(f, prm);
+
+  // screening with too little room falls back to the full QP
+  prm.screen_max_rows = 1;
+  ASIF asif_fb(f, prm);
+
+  smooth::SO3d g           = smooth::SO3d::Random();
+  Eigen::Vector3<double> u = Eigen::Vector3d(0.5, -0.5, 0.2);
+
+  for (auto i = 0u; i < 3; ++i) {
+    const auto [u_full, code_full] = asif(g, u, h, bu);
+    const auto [u_scr, code_scr]   = asif_scr(g, u, h, bu);
+    const auto [u_fb, code_fb]     = asif_fb(g, u, h, bu);
+
+    ASSERT_EQ(code_full, smooth::feedback::QPSolutionStatus::Optimal);
+    ASSERT_EQ(code_scr, smooth::feedback::QPSolutionStatus::Optimal);
+    ASSERT_EQ(code_fb, smooth::feedback::QPSolutionStatus::Optimal);
+    ASSERT_LE((u_scr - u_full).cwiseAbs().maxCoeff(), 1e-2);
+    ASSERT_LE((u_fb - u_full).cwiseAbs().maxCoeff(), 1e-2);
+
+    g = g * smooth::SO3d::exp(0.01 * u_full);
+  }
+}
+
+TEST(Asif, FilterClosedForm)
+{
+  auto f  = []<typename T>(const X<T> &, const U<T> & u) -> smooth::Tangent<X<T>> { return u; };
+  auto h  = []<typename T>(T, const X<T> & g) -> Eigen::Vector<T, 1> { return Eigen::Vector<T, 1>(0.1 - g.log().x()); };
+  auto bu = []<typename T>(T, const X<T> &) -> U<T> { return U<T>(-1, 0, 0); };
+
+  // single barrier constraint and no input bounds
+  smooth::feedback::ASIFilterParams<U<double>> prm{
+    .nh          = 1,
+    .asif        = {.K = 1},
+    .qp          = {.eps_abs = 1e-9f, .eps_rel = 1e-9f, .polish = false},
+    .closed_form = true,
+  };
+
+  using ASIF = smooth::feedback::ASIFilter<X<double>, U<double>, decltype(f)>;
+
+  ASIF asif_cf(f, prm);
+  prm.closed_form = false;
+  ASIF asif_qp(f, prm);
+
+  // desired input drives state out of the safe set
+  const smooth::SO3d g           = smooth::SO3d::exp(Eigen::Vector3d(0.09, 0, 0));
+  const Eigen::Vector3<double> u = Eigen::Vector3d(1, 0.5, 0);
+
+  const auto [u_cf, code_cf] = asif_cf(g, u, h, bu);
+  const auto [u_qp, code_qp] = asif_qp(g, u, h, bu);
+
+  ASSERT_TRUE(asif_cf.closed_form());
+  ASSERT_FALSE(asif_qp.closed_form());
+  ASSERT_EQ(code_cf, smooth::feedback::QPSolutionStatus::Optimal);
+  ASSERT_EQ(code_qp, smooth::feedback::QPSolutionStatus::Optimal);
+  ASSERT_LT(u_cf.x(), 1);
+  ASSERT_LE((u_cf - u_qp).cwiseAbs().maxCoeff(), 1e-4);
+}
+
+TEST(Asif, ClosedForm)
+{
+  static constexpr double inf = std::numeric_limits<double>::infinity();
+
+  // QP with structure from asif_to_qp_update(): 3 barrier rows, box input bounds, and relaxation bound
+  smooth::feedback::QuadraticProgram<6, 3, double> qp{
+    .P = Eigen::Vector3d(1, 2, 100).asDiagonal(),
+    .q = Eigen::Vector3d::Zero(),
+    .A = Eigen::Matrix<double, 6, 3>{
+      {1, 0.5, 1},
+      {-0.5, 1, 1},
+      {0.2, -1, 1},
+      {1, 0, 0},
+      {0, -2, 0},
+      {0, 0, 1},
+    },
+    .l = Eigen::Vector<double, 6>(-0.1, 0.6, -1, -0.3, -0.5, 0),
+    .u = Eigen::Vector<double, 6>(inf, inf, inf, 0.4, 0.5, inf),
+  };
+
+  smooth::feedback::QPSolution<6, 3, double> sol{
+    .iter   = 0,
+    .primal = Eigen::Vector3d::Zero(),
+    .dual   = Eigen::Vector<double, 6>::Zero(),
+  };
+
+  const auto ref = smooth::feedback::solve_qp(qp, {.eps_abs = 1e-9f, .eps_rel = 1e-9f, .max_iter = 100000});
+
+  // second barrier constraint is active and second input saturates
+  ASSERT_TRUE(smooth::feedback::asif_qp_closed_form(qp, 3, sol));
+  ASSERT_EQ(sol.code, smooth::feedback::QPSolutionStatus::Optimal);
+  ASSERT_NEAR(sol.primal(1), 0.25, 1e-9);
+  ASSERT_LE((sol.primal - ref.primal).cwiseAbs().maxCoeff(), 1e-6);
+  ASSERT_LE((sol.dual - ref.dual).cwiseAbs().maxCoeff(), 1e-4);
+  ASSERT_NEAR(sol.objective, ref.objective, 1e-6);
+
+  // two active barrier constraints
+  qp.l(0) = 0.5;
+  ASSERT_FALSE(smooth::feedback::asif_qp_closed_form(qp, 3, sol));
+
+  // general input bounds
+  qp.l(0)    = -0.1;
+  qp.A(3, 1) = 1;
+  ASSERT_FALSE(smooth::feedback::asif_qp_closed_form(qp, 3, sol));
+}
+
+TEST(Asif, FilterBatch)
+{
+  auto f  = []<typename T>(const X<T> &, const U<T> & u) -> smooth::Tangent<X<T>> { return u; };
+  auto h  = []<typename T>(T, const X<T> & g) -> Eigen::Vector3<T> { return g.log(); };
+  auto bu = []<typename T>(T, const X<T> &) -> U<T> { return U<T>(1, 1, 1); };
+
+  static constexpr std::size_t n_agents = 5;
+
+  smooth::feedback::ASIFilterParams<U<double>> prm{
+    .nh   = 3,
+    .asif = {.K = 10},
+    .qp   = {.polish = false},
+  };
+
+  smooth::feedback::ASIFilterBatch<X<double>, U<double>, decltype(f)> batch(n_agents, f, prm, 2);
+  ASSERT_EQ(batch.size(), n_agents);
+
+  std::vector<smooth::SO3d> gs;
+  std::vector<Eigen::Vector3d> us;
+  for (auto i = 0u; i < n_agents; ++i) {
+    gs.push_back(smooth::SO3d::Random());
+    us.push_back(Eigen::Vector3d::Random());
+  }
+
+  const auto & res = batch(gs, us, h, bu);
+
+  ASSERT_EQ(res.u.size(), n_agents);
+  ASSERT_EQ(res.code.size(), n_agents);
+
+  for (auto i = 0u; i < n_agents; ++i) {
+    smooth::feedback::ASIFilter<X<double>, U<double>, decltype(f)> asif(f, prm);
+    const auto [u_i, code_i] = asif(gs[i], us[i], h, bu);
+
+    ASSERT_EQ(res.code[i], code_i);
+    ASSERT_LE((res.u[i] - u_i).cwiseAbs().maxCoeff(), 1e-6);
+  }
+
+  // worker threads are re-used in subsequent calls
+  const auto codes = res.code;
+  for (auto k = 0u; k < 3; ++k) {
+    const auto & res_k = batch(gs, us, h, bu);
+    ASSERT_EQ(res_k.code, codes);
+  }
+}
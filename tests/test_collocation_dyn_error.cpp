@@ -77,3 +77,32 @@ TEST(CollocationDyn, DynError)
 
   ASSERT_EQ(m.N_ivals(), Npre);
 }
+
+TEST(CollocationDyn, DynErrorThreads)
+{
+  const auto f =
+    []<typename T>(const T &, const Eigen::Vector<T, 2> & x, const Eigen::Vector<T, 1> & u) -> Eigen::Vector<T, 2> {
+    return Eigen::Vector<T, 2>{{x.y(), u.x() - x.x()}};
+  };
+
+  const auto xfun = [](const double t) -> Eigen::Vector<double, 2> {
+    return Eigen::Vector<double, 2>{{std::sin(t), std::cos(2 * t)}};
+  };
+  const auto ufun = [](const double t) -> Eigen::Vector<double, 1> { return Eigen::Vector<double, 1>{{t * t}}; };
+
+  smooth::feedback::Mesh<3, 6> m;
+  m.refine_ph(0, 13 * 3);
+  ASSERT_EQ(m.N_ivals(), 13);
+
+  const auto errs = smooth::feedback::mesh_dyn_error(f, m, 0, 3, xfun, ufun);
+  ASSERT_EQ(errs.size(), 13);
+
+  for (auto n_threads : {2u, 4u, 13u, 20u}) {
+    smooth::feedback::ThreadPool pool(n_threads);
+    for (auto i = 0u; i < 2; ++i) {
+      const auto errs_th = smooth::feedback::mesh_dyn_error(f, m, 0, 3, xfun, ufun, &pool);
+      ASSERT_EQ(errs_th.size(), errs.size());
+      ASSERT_TRUE(errs_th.isApprox(errs));
+    }
+  }
+}
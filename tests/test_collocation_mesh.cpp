@@ -124,6 +124,38 @@ TEST(CollocationMesh, DifferentiationIntegration)
   }
 }
 
+TEST(CollocationMesh, UnscaledMatrices)
+{
+  // tables are compile-time constants
+  static constexpr auto D = smooth::feedback::detail::lgr_diffmat_v<4>;
+  static constexpr auto I = smooth::feedback::detail::lgr_intmat_v<4>;
+  static_assert(D.size() == 5 && D[0].size() == 4);
+  static_assert(I.size() == 4 && I[0].size() == 4);
+
+  smooth::feedback::Mesh<3, 6> m;
+  m.refine_ph(0, 30);
+  m.increase_degrees();
+
+  for (auto ival = 0u; ival < m.N_ivals(); ++ival) {
+    const auto k = static_cast<Eigen::Index>(m.N_colloc_ival(ival));
+
+    const auto [alpha_d, D_us] = m.interval_diffmat_unscaled(ival);
+    const auto [alpha_i, I_us] = m.interval_intmat_unscaled(ival);
+
+    ASSERT_EQ(D_us.rows(), k + 1);
+    ASSERT_EQ(D_us.cols(), k);
+    ASSERT_EQ(I_us.rows(), k);
+    ASSERT_EQ(I_us.cols(), k);
+
+    ASSERT_TRUE(Eigen::MatrixXd(alpha_d * D_us).isApprox(Eigen::MatrixXd(m.interval_diffmat(ival))));
+    ASSERT_TRUE(Eigen::MatrixXd(alpha_i * I_us).isApprox(Eigen::MatrixXd(m.interval_intmat(ival))));
+
+    // integration matrix inverts the lower block of the differentiation matrix
+    const Eigen::MatrixXd prod = m.interval_diffmat(ival).bottomRows(k) * m.interval_intmat(ival);
+    ASSERT_TRUE(prod.isApprox(Eigen::MatrixXd::Identity(k, k), 1e-10));
+  }
+}
+
 TEST(CollocationMesh, FunctionEval)
 {
   smooth::feedback::Mesh<5, 5> m;
@@ -193,3 +225,95 @@ TEST(CollocationMesh, IntervalNodes)
   for (auto w : all_weights) { sum += w; }
   ASSERT_NEAR(sum, 1., 1e-9);
 }
+
+TEST(CollocationMesh, EvalMany)
+{
+  smooth::feedback::Mesh<3, 8> m;
+  m.refine_ph(0, 20);
+  m.refine_ph(2, 6);
+
+  std::size_t N_before = 0;
+  for (auto i = 0u; i < m.N_ivals(); ++i) {
+    ASSERT_EQ(m.N_colloc_before(i), N_before);
+    N_before += m.N_colloc_ival(i);
+  }
+  ASSERT_EQ(m.N_colloc_before(m.N_ivals()), m.N_colloc());
+  ASSERT_EQ(m.N_colloc(), N_before);
+
+  const Eigen::VectorXd ts = Eigen::VectorXd::LinSpaced(200, -0.05, 1.05);
+
+  for (const bool extend : {true, false}) {
+    const Eigen::MatrixXd vals = Eigen::MatrixXd::Random(3, m.N_colloc() + (extend ? 1 : 0));
+
+    for (const auto p : {0u, 1u}) {
+      const Eigen::MatrixXd xs = m.eval_many(ts, vals.colwise(), p, extend);
+      ASSERT_EQ(xs.rows(), 3);
+      ASSERT_EQ(xs.cols(), ts.size());
+
+      for (Eigen::Index i = 0; i < ts.size(); ++i) {
+        const auto x = m.eval<Eigen::VectorXd>(ts(i), vals.colwise(), p, extend);
+        ASSERT_TRUE(xs.col(i).isApprox(x, 1e-10));
+      }
+    }
+  }
+}
+
+TEST(CollocationMesh, FixedMesh)
+{
+  smooth::feedback::Mesh<5, 5> m(3);
+  smooth::feedback::FixedMesh<5, 3> fm;
+
+  static_assert(smooth::feedback::MeshType<decltype(fm)>);
+  static_assert(decltype(fm)::N_colloc() == 15);
+
+  ASSERT_EQ(m.N_ivals(), fm.N_ivals());
+  ASSERT_EQ(m.N_colloc(), fm.N_colloc());
+
+  for (const auto & [t1, t2] : smooth::utils::zip(m.all_nodes(), fm.all_nodes())) { ASSERT_NEAR(t1, t2, 1e-12); }
+  for (const auto & [w1, w2] : smooth::utils::zip(m.all_weights(), fm.all_weights())) { ASSERT_NEAR(w1, w2, 1e-12); }
+
+  for (auto i = 0u; i < m.N_ivals(); ++i) {
+    ASSERT_EQ(m.N_colloc_ival(i), fm.N_colloc_ival(i));
+    ASSERT_EQ(m.N_colloc_before(i), fm.N_colloc_before(i));
+    ASSERT_DOUBLE_EQ(m.interval_start(i), fm.interval_start(i));
+    ASSERT_EQ(m.interval_find(m.interval_start(i) + 0.01), fm.interval_find(fm.interval_start(i) + 0.01));
+
+    for (const auto & [t1, t2] : smooth::utils::zip(m.interval_nodes(i), fm.interval_nodes(i))) {
+      ASSERT_NEAR(t1, t2, 1e-12);
+    }
+    for (const auto & [w1, w2] : smooth::utils::zip(m.interval_weights(i), fm.interval_weights(i))) {
+      ASSERT_NEAR(w1, w2, 1e-12);
+    }
+
+    ASSERT_TRUE(m.interval_diffmat(i).isApprox(fm.interval_diffmat(i)));
+    ASSERT_TRUE(m.interval_intmat(i).isApprox(fm.interval_intmat(i)));
+
+    const auto [alpha1, D1] = m.interval_diffmat_unscaled(i);
+    const auto [alpha2, D2] = fm.interval_diffmat_unscaled(i);
+    ASSERT_DOUBLE_EQ(alpha1, alpha2);
+    ASSERT_TRUE(D1.isApprox(D2));
+
+    const auto [beta1, I1] = m.interval_intmat_unscaled(i);
+    const auto [beta2, I2] = fm.interval_intmat_unscaled(i);
+    ASSERT_DOUBLE_EQ(beta1, beta2);
+    ASSERT_TRUE(I1.isApprox(I2));
+
+    for (const bool extend : {true, false}) {
+      ASSERT_TRUE(m.interval_basis(i, extend).isApprox(fm.interval_basis(i, extend)));
+    }
+  }
+
+  const Eigen::VectorXd ts = Eigen::VectorXd::LinSpaced(50, -0.05, 1.05);
+  for (const bool extend : {true, false}) {
+    const Eigen::MatrixXd vals = Eigen::MatrixXd::Random(2, m.N_colloc() + (extend ? 1 : 0));
+
+    for (Eigen::Index i = 0; i < ts.size(); ++i) {
+      const auto x1 = m.eval<Eigen::VectorXd>(ts(i), vals.colwise(), 0, extend);
+      const auto x2 = fm.eval<Eigen::VectorXd>(ts(i), vals.colwise(), 0, extend);
+      ASSERT_TRUE(x1.isApprox(x2, 1e-10));
+    }
+
+    ASSERT_TRUE(
+      m.eval_many(ts, vals.colwise(), 1, extend).isApprox(fm.eval_many(ts, vals.colwise(), 1, extend), 1e-10));
+  }
+}
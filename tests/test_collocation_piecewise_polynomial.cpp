@@ -0,0 +1,128 @@
+// smooth_feedback: Control theory on Lie groups
+// https://github.com/pettni/smooth_feedback
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+// Copyright (c) 2021 Petter Nilsson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <Eigen/Core>
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "smooth/feedback/collocation/piecewise_polynomial.hpp"
+
+TEST(CollocationPiecewisePolynomial, MeshEval)
+{
+  smooth::feedback::Mesh<3, 8> mesh;
+  mesh.refine_ph(0, 20);
+  mesh.refine_ph(1, 7);
+
+  const double t0 = 1, tf = 4;
+
+  for (const bool extend : {true, false}) {
+    const Eigen::MatrixXd vals = Eigen::MatrixXd::Random(3, mesh.N_colloc() + (extend ? 1 : 0));
+
+    const smooth::feedback::PiecewisePolynomial<3> poly(mesh, vals, t0, tf, extend);
+    ASSERT_EQ(poly.N_ivals(), mesh.N_ivals());
+    ASSERT_DOUBLE_EQ(poly.t0(), t0);
+    ASSERT_DOUBLE_EQ(poly.tf(), tf);
+
+    // monotone queries, including extrapolation
+    for (double t = 0.5; t < 4.5; t += 0.01) {
+      const auto x_mesh = mesh.eval<Eigen::Vector3d>((t - t0) / (tf - t0), vals.colwise(), 0, extend);
+      ASSERT_LE((poly(t) - x_mesh).cwiseAbs().maxCoeff(), 1e-9);
+    }
+
+    // random queries
+    for (auto i = 0u; i < 100; ++i) {
+      const double t    = t0 + (tf - t0) * (Eigen::Vector<double, 1>::Random()(0) + 1) / 2;
+      const auto x_mesh = mesh.eval<Eigen::Vector3d>((t - t0) / (tf - t0), vals.colwise(), 0, extend);
+      ASSERT_LE((poly(t) - x_mesh).cwiseAbs().maxCoeff(), 1e-9);
+    }
+  }
+}
+
+TEST(CollocationPiecewisePolynomial, Interpolation)
+{
+  smooth::feedback::Mesh<5, 5> mesh(4);
+
+  // values of a polynomial of degree <= 5 are reproduced exactly
+  const auto f = [](double t) { return Eigen::Vector2d(1 + 2 * t - t * t * t, 3 * t * t * t * t * t - t); };
+
+  Eigen::MatrixXd vals(2, mesh.N_colloc() + 1);
+  for (auto i = 0; const double tau : mesh.all_nodes()) { vals.col(i++) = f(2 * tau); }
+
+  const smooth::feedback::PiecewisePolynomial<2> poly(mesh, vals, 0, 2);
+
+  for (double t = 0; t <= 2; t += 0.05) { ASSERT_TRUE(poly(t).isApprox(f(t), 1e-9)); }
+
+  // evaluator caches the interval for monotone queries
+  auto ev = poly.evaluator();
+  for (double t = 0; t <= 2; t += 0.05) {
+    ASSERT_TRUE(ev(t).isApprox(f(t), 1e-9));
+    ASSERT_EQ(ev.interval(), poly.interval_find(t));
+  }
+  ASSERT_EQ(ev.interval(), 3u);
+  ASSERT_TRUE(ev(0.1).isApprox(f(0.1), 1e-9));
+  ASSERT_EQ(ev.interval(), 0u);
+}
+
+TEST(CollocationPiecewisePolynomial, Cursor)
+{
+  smooth::feedback::Mesh<5, 5> mesh(4);
+
+  const Eigen::MatrixXd vals = Eigen::MatrixXd::Random(2, mesh.N_colloc() + 1);
+  const smooth::feedback::PiecewisePolynomial<2> poly(mesh, vals, 0, 2);
+
+  // intervals are [0, 0.5), [0.5, 1), [1, 1.5), [1.5, 2]
+  std::size_t cursor = 0;
+  for (const auto & [t, i] : std::vector<std::pair<double, std::size_t>>{
+         {0.1, 0}, {0.6, 1}, {0.7, 1}, {1.2, 2}, {1.9, 3}, {2.5, 3}, {0.2, 0}, {-1, 0}}) {
+    ASSERT_TRUE(poly(t, cursor).isApprox(poly(t)));
+    ASSERT_EQ(cursor, i);
+  }
+
+  // type-erased solution
+  const std::function<Eigen::Vector2d(double)> fun = smooth::feedback::PiecewisePolynomial<2>(poly).into_callable();
+  for (double t = 0; t <= 2; t += 0.05) { ASSERT_TRUE(fun(t).isApprox(poly(t))); }
+  ASSERT_TRUE(fun(0.1).isApprox(poly(0.1)));
+}
+
+TEST(CollocationPiecewisePolynomial, Batch)
+{
+  smooth::feedback::Mesh<3, 8> mesh;
+  mesh.refine_ph(0, 30);
+
+  const Eigen::MatrixXd vals = Eigen::MatrixXd::Random(4, mesh.N_colloc() + 1);
+  const smooth::feedback::PiecewisePolynomial<> poly(mesh, vals, 0, 2);
+
+  const Eigen::VectorXd ts_sorted = Eigen::VectorXd::LinSpaced(500, -0.1, 2.1);
+  const Eigen::VectorXd ts_random = Eigen::VectorXd::Random(500) + Eigen::VectorXd::Ones(500);
+
+  for (const auto & ts : {ts_sorted, ts_random}) {
+    Eigen::MatrixXd out(4, ts.size());
+    poly.eval(ts, out);
+    for (Eigen::Index i = 0; i < ts.size(); ++i) { ASSERT_TRUE(out.col(i).isApprox(poly(ts(i)), 1e-12)); }
+  }
+}
@@ -28,6 +28,9 @@
 #include <smooth/so3.hpp>
 #include <unsupported/Eigen/MatrixFunctions>
 
+#include <tuple>
+#include <vector>
+
 TEST(Ekf, NoCrash)
 {
   smooth::feedback::EKF<smooth::SO3d> ekf;
@@ -178,3 +181,111 @@ TEST(Ekf, PredictTimeCut)
   // exact solution
   ASSERT_TRUE(ekf.estimate().isApprox(xhat + b * tau));
 }
+
+TEST(Ekf, PredictDiscreteLinear)
+{
+  static constexpr int Nx = 4;
+
+  using Vec = Eigen::Matrix<double, Nx, 1>;
+  using Mat = Eigen::Matrix<double, Nx, Nx>;
+
+  const Vec xhat = Vec::Random();
+  const Mat A    = Mat::Random();
+  const Mat B    = Mat::Random();
+  const Mat Q    = B * B.transpose();
+  const Mat P    = Mat::Identity() + 0.5 * Mat::Ones();
+
+  const auto f = [&A]<typename T>(double, const Eigen::Matrix<T, Nx, 1> & xvar) -> Eigen::Matrix<T, Nx, 1> {
+    return A * xvar;
+  };
+
+  // reference: continuous-time covariance ODE
+  smooth::feedback::EKF<Vec, smooth::diff::Type::Numerical, boost::numeric::odeint::runge_kutta4> ekf_ref;
+  ekf_ref.reset(xhat, P);
+  ekf_ref.predict(f, Q, 0.6, 1e-3);
+
+  // two discrete steps (second one uses cached transition)
+  smooth::feedback::EKF<Vec, smooth::diff::Type::Numerical, boost::numeric::odeint::runge_kutta4> ekf;
+  ekf.reset(xhat, P);
+  ekf.predict_discrete(f, Q, 0.3, 1e-3);
+  ekf.predict_discrete(f, Q, 0.3, 1e-3);
+
+  ASSERT_TRUE(ekf.estimate().isApprox((A * 0.6).exp() * xhat, 1e-6));
+  ASSERT_TRUE(ekf.covariance().isApprox(ekf_ref.covariance(), 1e-6));
+
+  // one discrete step
+  ekf.reset(xhat, P);
+  ekf.predict_discrete(f, Q, 0.6, 1e-3);
+
+  ASSERT_TRUE(ekf.covariance().isApprox(ekf_ref.covariance(), 1e-6));
+}
+
+TEST(Ekf, UpdateBatch)
+{
+  static constexpr int Nx = 6;
+
+  using Vec = Eigen::Matrix<double, Nx, 1>;
+  using Mat = Eigen::Matrix<double, Nx, Nx>;
+
+  const Mat B    = Mat::Random();
+  const Mat P    = B * B.transpose() + Mat::Identity();
+  const Vec xhat = Vec::Random();
+  const Vec x    = Vec::Random();
+
+  const Eigen::Matrix<double, 2, Nx> H1 = Eigen::Matrix<double, 2, Nx>::Random();
+  const Eigen::Matrix<double, 3, Nx> H2 = Eigen::Matrix<double, 3, Nx>::Random();
+  const Eigen::Matrix3d C               = Eigen::Matrix3d::Random();
+
+  const Eigen::Matrix2d R1 = Eigen::Vector2d(0.5, 1.0).asDiagonal();
+  const Eigen::Matrix3d R2 = C * C.transpose() + Eigen::Matrix3d::Identity();
+
+  const auto h1 = [&H1]<typename T>(const Eigen::Matrix<T, Nx, 1> & v) -> Eigen::Matrix<T, 2, 1> { return H1 * v; };
+  const auto h2 = [&H2]<typename T>(const Eigen::Matrix<T, Nx, 1> & v) -> Eigen::Matrix<T, 3, 1> { return H2 * v; };
+
+  const Eigen::Vector2d y1 = H1 * x;
+  const Eigen::Vector3d y2 = H2 * x;
+
+  // stacked linear kalman update
+  Eigen::Matrix<double, 5, Nx> H;
+  H << H1, H2;
+  Eigen::Matrix<double, 5, 5> R = Eigen::Matrix<double, 5, 5>::Zero();
+  R.topLeftCorner<2, 2>()       = R1;
+  R.bottomRightCorner<3, 3>()   = R2;
+  Eigen::Matrix<double, 5, 1> y;
+  y << y1, y2;
+
+  const Eigen::Matrix<double, 5, 5> S  = H * P * H.transpose() + R;
+  const Eigen::Matrix<double, Nx, 5> K = P * H.transpose() * S.inverse();
+  const Vec x_new                      = xhat + K * (y - H * xhat);
+  const Mat P_new                      = (Mat::Identity() - K * H) * P;
+
+  using smooth::feedback::EKFBatchMode;
+
+  for (auto mode : {EKFBatchMode::Auto, EKFBatchMode::Stacked, EKFBatchMode::Sequential}) {
+    smooth::feedback::EKF<Vec> ekf;
+    ekf.reset(xhat, P);
+    ekf.update_batch(std::forward_as_tuple(std::forward_as_tuple(h1, y1, R1), std::forward_as_tuple(h2, y2, R2)), mode);
+
+    ASSERT_TRUE(x_new.isApprox(ekf.estimate(), 1e-6));
+    ASSERT_TRUE(P_new.isApprox(ekf.covariance(), 1e-6));
+  }
+
+  // range of measurements of the same type is equal to repeated updates for linear models
+  std::vector<std::tuple<decltype(h2), Eigen::Vector3d, Eigen::Matrix3d>> ms;
+  ms.emplace_back(h2, y2, R2);
+  ms.emplace_back(h2, y2 + Eigen::Vector3d::Ones(), R2);
+
+  smooth::feedback::EKF<Vec> ekf_ref;
+  ekf_ref.reset(xhat, P);
+  ekf_ref.update(h2, y2, R2);
+  ekf_ref.update(h2, Eigen::Vector3d(y2 + Eigen::Vector3d::Ones()), R2);
+
+  for (auto mode : {EKFBatchMode::Stacked, EKFBatchMode::Sequential}) {
+    smooth::feedback::EKF<Vec> ekf;
+    ekf.reset(xhat, P);
+    ekf.update_batch(ms, mode);
+
+    ASSERT_TRUE(ekf_ref.estimate().isApprox(ekf.estimate(), 1e-6));
+    ASSERT_TRUE(ekf_ref.covariance().isApprox(ekf.covariance(), 1e-6));
+  }
+}
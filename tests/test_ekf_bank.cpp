@@ -0,0 +1,207 @@
+// smooth_feedback: Control theory on Lie groups
+// https://github.com/pettni/smooth_feedback
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+// Copyright (c) 2021 Petter Nilsson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gtest/gtest.h>
+#include <smooth/feedback/ekf.hpp>
+#include <smooth/feedback/ekf_bank.hpp>
+#include <smooth/se3.hpp>
+#include <smooth/so3.hpp>
+
+#include <array>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+TEST(EkfBank, CompareEkf)
+{
+  static constexpr int N = 7;
+
+  using Vec = Eigen::Vector3d;
+
+  const auto dyn = []<typename T>(double, const Eigen::Vector3<T> & x) -> Eigen::Vector3<T> {
+    using std::sin;
+    return Eigen::Vector3<T>(x(1), -sin(x(0)) - T(0.1) * x(1), T(0.3) * x(0) * x(2));
+  };
+  const auto meas = []<typename T>(const Eigen::Vector3<T> & x) -> Eigen::Vector2<T> {
+    return Eigen::Vector2<T>(x(0) * x(2), x(1));
+  };
+
+  Eigen::Matrix3d Q = 0.1 * Eigen::Matrix3d::Identity();
+  Q(0, 1)           = 0.02;
+  Q(1, 0)           = 0.02;
+  const Eigen::Matrix2d R{{0.3, 0.1}, {0.1, 0.4}};
+
+  smooth::feedback::EKFBank<Vec, N, smooth::diff::Type::Numerical> bank;
+  std::array<smooth::feedback::EKF<Vec, smooth::diff::Type::Numerical>, N> ekfs;
+
+  for (auto i = 0; i < N; ++i) {
+    const Vec x             = Vec::Random();
+    const Eigen::Matrix3d B = Eigen::Matrix3d::Random();
+    const Eigen::Matrix3d P = B * B.transpose() + Eigen::Matrix3d::Identity();
+    bank.reset(i, x, P);
+    ekfs[static_cast<std::size_t>(i)].reset(x, P);
+  }
+
+  std::array<Eigen::Vector2d, N> ys;
+  for (auto & y : ys) { y.setRandom(); }
+
+  // only update some filters
+  decltype(bank)::Mask mask = decltype(bank)::Mask::Constant(true);
+  mask(2)                   = false;
+  mask(5)                   = false;
+
+  for (auto it = 0u; it < 3; ++it) {
+    bank.predict(dyn, Q, 0.3, 0.1);
+    for (auto & ekf : ekfs) { ekf.predict(dyn, Q, 0.3, 0.1); }
+
+    bank.update(meas, ys, R, mask);
+    for (auto i = 0; i < N; ++i) {
+      if (mask(i)) { ekfs[static_cast<std::size_t>(i)].update(meas, ys[static_cast<std::size_t>(i)], R); }
+    }
+
+    for (auto i = 0; i < N; ++i) {
+      const auto & ekf = ekfs[static_cast<std::size_t>(i)];
+      ASSERT_TRUE(bank.estimate(i).isApprox(ekf.estimate(), 1e-10));
+      ASSERT_TRUE(bank.covariance(i).isApprox(ekf.covariance(), 1e-10));
+    }
+  }
+}
+
+TEST(EkfBank, MaskSemiDefinite)
+{
+  static constexpr int N = 3;
+
+  using Vec = Eigen::Vector2d;
+
+  const auto meas = []<typename T>(const Eigen::Vector2<T> & x) -> Eigen::Vector2<T> { return x; };
+
+  // semi-definite measurement covariance
+  const Eigen::Matrix2d R = Eigen::Matrix2d::Zero();
+
+  smooth::feedback::EKFBank<Vec, N> bank;
+  for (auto i = 0; i < N; ++i) { bank.reset(i, Vec::Zero(), Eigen::Matrix2d::Identity()); }
+
+  std::array<Eigen::Vector2d, N> ys;
+  ys.fill(Eigen::Vector2d::Ones());
+
+  decltype(bank)::Mask mask = decltype(bank)::Mask::Constant(true);
+  mask(1)                   = false;
+
+  bank.update(meas, ys, R, mask);
+
+  // inactive filter is unchanged
+  ASSERT_TRUE(bank.estimate(1).isZero());
+  ASSERT_TRUE(bank.covariance(1).isApprox(Eigen::Matrix2d::Identity()));
+
+  // active filters take the measurement
+  for (const auto i : {0, 2}) {
+    ASSERT_TRUE(bank.estimate(i).isApprox(Eigen::Vector2d::Ones(), 1e-10));
+    ASSERT_TRUE(bank.covariance(i).allFinite());
+    ASSERT_LE(bank.covariance(i).cwiseAbs().maxCoeff(), 1e-10);
+  }
+}
+
+TEST(EkfBank, CompareEkfSO3)
+{
+  static constexpr int N = 4;
+
+  const auto dyn = []<typename T>(T, const smooth::SO3<T> & g) -> Eigen::Vector3<T> {
+    return Eigen::Vector3<T>(T(1), T(0.2), T(0)) + T(0.1) * g.log();
+  };
+  const auto meas = []<typename T>(const smooth::SO3<T> & g) -> Eigen::Vector3<T> {
+    return g * Eigen::Vector3<T>::UnitZ();
+  };
+
+  const Eigen::Matrix3d Q = Eigen::Vector3d(0.1, 0.2, 0.3).asDiagonal();
+  const Eigen::Matrix3d R = 0.05 * Eigen::Matrix3d::Identity();
+
+  smooth::feedback::EKFBank<smooth::SO3d, N> bank;
+  std::array<smooth::feedback::EKF<smooth::SO3d>, N> ekfs;
+
+  for (auto i = 0; i < N; ++i) {
+    const smooth::SO3d g0 = smooth::SO3d::Random();
+    bank.reset(i, g0, Eigen::Matrix3d::Identity());
+    ekfs[static_cast<std::size_t>(i)].reset(g0, Eigen::Matrix3d::Identity());
+  }
+
+  std::array<Eigen::Vector3d, N> ys;
+  ys.fill(Eigen::Vector3d::UnitY());
+
+  for (auto it = 0u; it < 3; ++it) {
+    bank.predict(dyn, Q, 0.5, 0.1);
+    bank.update(meas, ys, R);
+
+    for (auto & ekf : ekfs) {
+      ekf.predict(dyn, Q, 0.5, 0.1);
+      ekf.update(meas, Eigen::Vector3d::UnitY(), R);
+    }
+
+    for (auto i = 0; i < N; ++i) {
+      const auto & ekf = ekfs[static_cast<std::size_t>(i)];
+      ASSERT_LE((bank.estimate(i) - ekf.estimate()).norm(), 1e-10);
+      ASSERT_TRUE(bank.covariance(i).isApprox(ekf.covariance(), 1e-10));
+    }
+  }
+}
+
+TEST(EkfBank, Large)
+{
+  static constexpr int N = 1000;
+
+  const auto dyn = []<typename T>(T, const smooth::SE3<T> &) -> Eigen::Vector<T, 6> {
+    return Eigen::Vector<T, 6>(T(1), T(0), T(0.1), T(0), T(0.2), T(0.3));
+  };
+  const auto meas = []<typename T>(const smooth::SE3<T> & g) -> Eigen::Vector3<T> {
+    return g * Eigen::Vector3<T>::UnitX();
+  };
+
+  const Eigen::Matrix<double, 6, 6> Q = 0.1 * Eigen::Matrix<double, 6, 6>::Identity();
+  const Eigen::Matrix3d R             = 0.05 * Eigen::Matrix3d::Identity();
+
+  auto bank = std::make_unique<smooth::feedback::EKFBank<smooth::SE3d, N>>();
+  std::vector<smooth::feedback::EKF<smooth::SE3d>> ekfs(N);
+
+  for (auto i = 0; i < N; ++i) {
+    const smooth::SE3d g0 = smooth::SE3d::Random();
+    bank->reset(i, g0, Eigen::Matrix<double, 6, 6>::Identity());
+    ekfs[static_cast<std::size_t>(i)].reset(g0, Eigen::Matrix<double, 6, 6>::Identity());
+  }
+
+  std::array<Eigen::Vector3d, N> ys;
+  for (auto & y : ys) { y.setRandom(); }
+
+  for (auto it = 0u; it < 2; ++it) {
+    bank->predict(dyn, Q, 0.2, 0.1);
+    bank->update(meas, ys, R);
+
+    for (auto i = 0; i < N; ++i) {
+      auto & ekf = ekfs[static_cast<std::size_t>(i)];
+      ekf.predict(dyn, Q, 0.2, 0.1);
+      ekf.update(meas, ys[static_cast<std::size_t>(i)], R);
+      ASSERT_LE((bank->estimate(i) - ekf.estimate()).norm(), 1e-8);
+      ASSERT_TRUE(bank->covariance(i).isApprox(ekf.covariance(), 1e-8));
+    }
+  }
+}
@@ -0,0 +1,98 @@
+// smooth_feedback: Control theory on Lie groups
+// https://github.com/pettni/smooth_feedback
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+// Copyright (c) 2021 Petter Nilsson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gtest/gtest.h>
+#include <smooth/feedback/ekf_delayed.hpp>
+
+using Vec = Eigen::Vector2d;
+using Y   = Eigen::Matrix<double, 1, 1>;
+
+namespace {
+
+const auto dyn = []<typename T>(double, const Eigen::Matrix<T, 2, 1> & x, const Y & u) -> Eigen::Matrix<T, 2, 1> {
+  return Eigen::Matrix<T, 2, 1>(x(1), T(u(0)) - T(0.1) * x(0));
+};
+
+const auto meas = []<typename T>(const Eigen::Matrix<T, 2, 1> & x) -> Eigen::Matrix<T, 1, 1> {
+  return x.template head<1>();
+};
+
+using Filter = smooth::feedback::DelayedEKF<Vec, Y, decltype(dyn), decltype(meas), smooth::diff::Type::Numerical>;
+
+}  // namespace
+
+TEST(EkfDelayed, OutOfOrder)
+{
+  const Eigen::Matrix2d Q = 0.1 * Eigen::Matrix2d::Identity();
+  const Y R{0.5};
+
+  // default step size: every call integrates in a single step
+  Filter f_in(dyn, Q, 10);
+  Filter f_oos(dyn, Q, 10);
+
+  f_in.reset(0, Vec(0, 1), Eigen::Matrix2d::Identity());
+  f_oos.reset(0, Vec(0, 1), Eigen::Matrix2d::Identity());
+
+  // measurements in order
+  ASSERT_TRUE(f_in.update(0.1, meas, Y{0.1}, R));
+  f_in.set_input(0.15, Y{1});
+  ASSERT_TRUE(f_in.update(0.2, meas, Y{0.25}, R));
+  f_in.predict(0.25);
+  ASSERT_TRUE(f_in.update(0.3, meas, Y{0.4}, R));
+  f_in.predict(0.35);
+
+  // measurement at 0.2 arrives last
+  ASSERT_TRUE(f_oos.update(0.1, meas, Y{0.1}, R));
+  f_oos.set_input(0.15, Y{1});
+  f_oos.predict(0.25);
+  ASSERT_TRUE(f_oos.update(0.3, meas, Y{0.4}, R));
+  f_oos.predict(0.35);
+  ASSERT_TRUE(f_oos.update(0.2, meas, Y{0.25}, R));
+
+  ASSERT_DOUBLE_EQ(f_in.time(), f_oos.time());
+  ASSERT_TRUE(f_in.estimate().isApprox(f_oos.estimate(), 1e-10));
+  ASSERT_TRUE(f_in.covariance().isApprox(f_oos.covariance(), 1e-10));
+}
+
+TEST(EkfDelayed, Capacity)
+{
+  const Eigen::Matrix2d Q = 0.1 * Eigen::Matrix2d::Identity();
+  const Y R{0.5};
+
+  Filter f(dyn, Q, 5, 0.01);
+  f.reset(0, Vec(0, 1), Eigen::Matrix2d::Identity());
+
+  for (auto i = 0u; i < 10; ++i) { ASSERT_TRUE(f.update(0.1 * (i + 1), meas, Y{0.1}, R)); }
+
+  ASSERT_EQ(f.history_size(), 5u);
+
+  // older than history
+  ASSERT_FALSE(f.update(0.2, meas, Y{0.1}, R));
+
+  // within history
+  ASSERT_TRUE(f.update(0.75, meas, Y{0.1}, R));
+  ASSERT_EQ(f.history_size(), 5u);
+  ASSERT_DOUBLE_EQ(f.time(), 1.0);
+}
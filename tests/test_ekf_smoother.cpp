@@ -0,0 +1,154 @@
+// smooth_feedback: Control theory on Lie groups
+// https://github.com/pettni/smooth_feedback
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+// Copyright (c) 2021 Petter Nilsson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gtest/gtest.h>
+#include <smooth/feedback/ekf_smoother.hpp>
+#include <unsupported/Eigen/MatrixFunctions>
+
+#include <cmath>
+#include <vector>
+
+using Vec = Eigen::Vector2d;
+using Mat = Eigen::Matrix2d;
+using Y   = Eigen::Matrix<double, 1, 1>;
+
+namespace {
+
+const Mat A{{0, 1}, {-0.5, -0.1}};
+
+const auto dyn = []<typename T>(double, const Eigen::Matrix<T, 2, 1> & x) -> Eigen::Matrix<T, 2, 1> {
+  return A * x;
+};
+
+const auto meas = []<typename T>(const Eigen::Matrix<T, 2, 1> & x) -> Eigen::Matrix<T, 1, 1> {
+  return x.template head<1>();
+};
+
+using Smoother =
+  smooth::feedback::FixedLagSmoother<Vec, smooth::diff::Type::Numerical, boost::numeric::odeint::runge_kutta4>;
+
+}  // namespace
+
+TEST(EkfSmoother, Linear)
+{
+  const Mat Q  = 0.1 * Mat::Identity();
+  const Y R    = Y{0.2};
+  const Mat P0 = Mat::Identity();
+  const Vec x0 = Vec(1, 0);
+
+  static constexpr std::size_t steps = 8;
+
+  const auto y = [](std::size_t i) { return Y{std::cos(0.3 * static_cast<double>(i))}; };
+
+  Smoother smoother(steps + 1);
+  smoother.reset(x0, P0);
+  smoother.update(meas, y(0), R);
+  for (auto i = 1u; i <= steps; ++i) {
+    smoother.predict(dyn, Q, 0.1, 1e-3);
+    smoother.update(meas, y(i), R);
+  }
+  smoother.smooth();
+
+  ASSERT_EQ(smoother.size(), steps + 1);
+
+  // reference: dense Kalman filter and RTS smoother
+  smooth::feedback::EKF<Vec, smooth::diff::Type::Numerical> ekf;
+  const Mat Phi = (A * 0.1).exp();
+  const Mat Qd  = [&] {
+    ekf.reset(Vec::Zero(), Mat::Zero());
+    ekf.predict_discrete(dyn, Q, 0.1);
+    return ekf.covariance();
+  }();
+
+  const Eigen::Matrix<double, 1, 2> H{{1, 0}};
+
+  std::vector<Vec> xf(steps + 1), xp(steps + 1);
+  std::vector<Mat> Pf(steps + 1), Pp(steps + 1);
+
+  for (auto i = 0u; i <= steps; ++i) {
+    if (i == 0) {
+      xp[i] = x0;
+      Pp[i] = P0;
+    } else {
+      xp[i] = Phi * xf[i - 1];
+      Pp[i] = Phi * Pf[i - 1] * Phi.transpose() + Qd;
+    }
+    const Eigen::Vector2d K = Pp[i] * H.transpose() / (H * Pp[i] * H.transpose() + R)(0);
+    xf[i]                   = xp[i] + K * (y(i) - H * xp[i]);
+    Pf[i]                   = (Mat::Identity() - K * H) * Pp[i];
+  }
+
+  Vec xs = xf[steps];
+  Mat Ps = Pf[steps];
+
+  ASSERT_TRUE(smoother.smoothed_estimate(steps).isApprox(xs, 1e-6));
+  ASSERT_TRUE(smoother.smoothed_covariance(steps).isApprox(Ps, 1e-6));
+
+  for (auto i = steps; i > 0; --i) {
+    const Mat C = Pf[i - 1] * Phi.transpose() * Pp[i].inverse();
+    xs          = xf[i - 1] + C * (xs - xp[i]);
+    Ps          = Pf[i - 1] + C * (Ps - Pp[i]) * C.transpose();
+
+    ASSERT_TRUE(smoother.smoothed_estimate(i - 1).isApprox(xs, 1e-6));
+    ASSERT_TRUE(smoother.smoothed_covariance(i - 1).isApprox(Ps, 1e-6));
+  }
+}
+
+TEST(EkfSmoother, Window)
+{
+  const Mat Q = 0.1 * Mat::Identity();
+  const Y R   = Y{0.2};
+
+  Smoother s_short(4);
+  Smoother s_long(100);
+
+  s_short.reset(Vec(1, 0), Mat::Identity());
+  s_long.reset(Vec(1, 0), Mat::Identity());
+
+  for (auto i = 0u; i < 20; ++i) {
+    const Y y{std::sin(0.2 * i)};
+
+    s_short.predict(dyn, Q, 0.1);
+    s_short.update(meas, y, R);
+
+    s_long.predict(dyn, Q, 0.1);
+    s_long.update(meas, y, R);
+  }
+
+  s_short.smooth();
+  s_long.smooth();
+
+  ASSERT_EQ(s_short.size(), 4u);
+  ASSERT_EQ(s_long.size(), 21u);
+
+  // truncating the window does not affect the backward pass
+  for (auto i = 0u; i < 4; ++i) {
+    ASSERT_TRUE(s_short.smoothed_estimate(i).isApprox(s_long.smoothed_estimate(17 + i), 1e-10));
+    ASSERT_TRUE(s_short.smoothed_covariance(i).isApprox(s_long.smoothed_covariance(17 + i), 1e-10));
+  }
+
+  // smoothing reduces uncertainty
+  ASSERT_LE(s_long.smoothed_covariance(10).trace(), s_long.smoothed_covariance(20).trace());
+}
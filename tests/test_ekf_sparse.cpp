@@ -0,0 +1,134 @@
+// smooth_feedback: Control theory on Lie groups
+// https://github.com/pettni/smooth_feedback
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+// Copyright (c) 2021 Petter Nilsson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gtest/gtest.h>
+#include <smooth/bundle.hpp>
+#include <smooth/feedback/ekf.hpp>
+#include <smooth/feedback/ekf_sparse.hpp>
+#include <smooth/so3.hpp>
+
+template<typename T>
+using Bundle = smooth::Bundle<smooth::SO3<T>, Eigen::Vector3<T>, Eigen::Vector3<T>, Eigen::Vector3<T>>;
+
+TEST(SparseEkf, CompareEkfLinear)
+{
+  static constexpr int Nx = 12;
+  static constexpr int Ny = 3;
+
+  using Vec = Eigen::Matrix<double, Nx, 1>;
+  using Mat = Eigen::Matrix<double, Nx, Nx>;
+
+  // block-diagonal dynamics with coupling between first two blocks
+  Mat A = Mat::Zero();
+  for (auto i = 0; i < Nx / 3; ++i) { A.block<3, 3>(3 * i, 3 * i).setRandom(); }
+  A.block<3, 3>(0, 3).setRandom();
+
+  // measurement of two blocks
+  Eigen::Matrix<double, Ny, Nx> H = Eigen::Matrix<double, Ny, Nx>::Zero();
+  H.block<3, 3>(0, 0).setRandom();
+  H.block<3, 3>(0, 9).setRandom();
+
+  // only upper triangular part of Q is used
+  Mat Q               = 0.1 * Mat::Identity();
+  Q.block<3, 3>(0, 3) = 0.01 * Eigen::Matrix3d::Ones();
+  Q.block<3, 3>(3, 0) = Eigen::Matrix3d::Random();
+
+  const Eigen::Matrix<double, Ny, Ny> R = 0.2 * Eigen::Matrix<double, Ny, Ny>::Identity();
+  const Vec x0                          = Vec::Random();
+  const Eigen::Matrix<double, Ny, 1> y  = Eigen::Matrix<double, Ny, 1>::Random();
+
+  const auto dyn = [&A]<typename T>(double, const Eigen::Matrix<T, Nx, 1> & xvar) -> Eigen::Matrix<T, Nx, 1> {
+    return A * xvar;
+  };
+  const auto meas = [&H]<typename T>(const Eigen::Matrix<T, Nx, 1> & xvar) -> Eigen::Matrix<T, Ny, 1> {
+    return H * xvar;
+  };
+
+  smooth::feedback::EKF<Vec, smooth::diff::Type::Numerical, boost::numeric::odeint::runge_kutta4> ekf;
+  smooth::feedback::SparseEKF<Vec, smooth::diff::Type::Numerical, boost::numeric::odeint::runge_kutta4> sekf;
+
+  ekf.reset(x0, Mat::Identity());
+  sekf.reset(x0, Mat::Identity());
+
+  for (auto i = 0u; i < 5; ++i) {
+    ekf.predict(dyn, Q, 0.1, 0.01);
+    sekf.predict(dyn, Q, 0.1, 0.01);
+
+    ASSERT_TRUE(ekf.estimate().isApprox(sekf.estimate(), 1e-10));
+    ASSERT_TRUE(ekf.covariance().isApprox(sekf.covariance(), 1e-10));
+
+    ekf.update(meas, y, R);
+    sekf.update(meas, y, R);
+
+    ASSERT_TRUE(ekf.estimate().isApprox(sekf.estimate(), 1e-10));
+    ASSERT_TRUE(ekf.covariance().isApprox(sekf.covariance(), 1e-10));
+  }
+
+  ASSERT_EQ(sekf.nnz_dynamics(), 5 * 9);
+}
+
+TEST(SparseEkf, CompareEkfBundle)
+{
+  // attitude with gyro bias and two landmarks
+  using G = Bundle<double>;
+
+  const auto dyn = []<typename T>(T, const Bundle<T> & g) -> Eigen::Matrix<T, 12, 1> {
+    Eigen::Matrix<T, 12, 1> ret;
+    ret.template head<3>() = Eigen::Vector3<T>(T(1), T(0.2), T(0)) - g.template part<1>();
+    ret.template tail<9>().setZero();
+    return ret;
+  };
+  const auto meas = []<typename T>(const Bundle<T> & g) -> Eigen::Vector3<T> {
+    return g.template part<0>().inverse() * g.template part<2>();
+  };
+
+  Eigen::Matrix<double, 12, 12> Q = Eigen::Matrix<double, 12, 12>::Zero();
+  Q.diagonal().head<6>().setConstant(0.1);
+  const Eigen::Matrix3d R = 0.05 * Eigen::Matrix3d::Identity();
+
+  smooth::feedback::EKF<G> ekf;
+  smooth::feedback::SparseEKF<G> sekf;
+
+  const G g0 = G::Random();
+  ekf.reset(g0, Eigen::Matrix<double, 12, 12>::Identity());
+  sekf.reset(g0, Eigen::Matrix<double, 12, 12>::Identity());
+
+  for (auto i = 0u; i < 5; ++i) {
+    ekf.predict(dyn, Q, 0.5, 0.1);
+    sekf.predict(dyn, Q, 0.5, 0.1);
+
+    ASSERT_LE((ekf.estimate() - sekf.estimate()).norm(), 1e-10);
+    ASSERT_TRUE(ekf.covariance().isApprox(sekf.covariance(), 1e-10));
+
+    ekf.update(meas, Eigen::Vector3d::UnitY(), R);
+    sekf.update(meas, Eigen::Vector3d::UnitY(), R);
+
+    ASSERT_LE((ekf.estimate() - sekf.estimate()).norm(), 1e-10);
+    ASSERT_TRUE(ekf.covariance().isApprox(sekf.covariance(), 1e-10));
+  }
+
+  // landmark states do not enter the dynamics
+  ASSERT_LE(sekf.nnz_dynamics(), 18);
+}
@@ -162,3 +162,36 @@ TEST(Mpc, Constructors)
   ASSERT_TRUE(u1.isApprox(u4));
   ASSERT_TRUE(u1.isApprox(u5));
 }
+
+TEST(Mpc, FixedMesh)
+{
+  using MPC_fixed_t =
+    smooth::feedback::MPC<T, X, U, MyDynamics, MyRunningConstraints, 4, smooth::diff::Type::Default, 3>;
+
+  MyDynamics f{};
+  MyRunningConstraints cr{};
+  Eigen::Vector2d crl = Eigen::Vector2d::Ones();
+
+  // default K = 10 gives 3 intervals with 4 points each
+  MPC_t mpc{f, cr, -crl, crl};
+  MPC_fixed_t mpc_fixed{f, cr, -crl, crl};
+
+  mpc.set_udes([](T) -> U { return U::Ones(); });
+  mpc.set_xdes_rel([]<typename S>(S) -> smooth::CastT<S, X> { return smooth::CastT<S, X>::Identity(); });
+  mpc_fixed.set_udes([](T) -> U { return U::Ones(); });
+  mpc_fixed.set_xdes_rel([]<typename S>(S) -> smooth::CastT<S, X> { return smooth::CastT<S, X>::Identity(); });
+
+  const X x = X::Random();
+
+  std::vector<X> xs, xs_fixed;
+  std::vector<U> us, us_fixed;
+
+  auto [u, code]             = mpc(1, x, us, xs);
+  auto [u_fixed, code_fixed] = mpc_fixed(1, x, us_fixed, xs_fixed);
+
+  ASSERT_EQ(code, smooth::feedback::QPSolutionStatus::Optimal);
+  ASSERT_EQ(code_fixed, smooth::feedback::QPSolutionStatus::Optimal);
+  ASSERT_TRUE(u.isApprox(u_fixed, 1e-6));
+  ASSERT_EQ(us.size(), us_fixed.size());
+  ASSERT_EQ(xs.size(), xs_fixed.size());
+}
@@ -0,0 +1,122 @@
+// smooth_feedback: Control theory on Lie groups
+// https://github.com/pettni/smooth_feedback
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+// Copyright (c) 2021 Petter Nilsson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <Eigen/Core>
+#include <gtest/gtest.h>
+
+#include "smooth/feedback/nlp_solver.hpp"
+
+/// @brief min x0^2 + x1^2 s.t. x0 + x1 = 1, 0 <= x0 <= 0.3
+struct QuadraticNLP
+{
+  std::size_t n() const { return 2; }
+  std::size_t m() const { return 1; }
+
+  Eigen::VectorXd xl() const { return Eigen::Vector2d{0, -std::numeric_limits<double>::infinity()}; }
+  Eigen::VectorXd xu() const { return Eigen::Vector2d{0.3, std::numeric_limits<double>::infinity()}; }
+
+  double f(const Eigen::VectorXd & x) const { return x.squaredNorm(); }
+  Eigen::SparseMatrix<double> df_dx(const Eigen::VectorXd & x) const
+  {
+    return Eigen::MatrixXd(2 * x.transpose()).sparseView();
+  }
+
+  Eigen::VectorXd g(const Eigen::VectorXd & x) const { return Eigen::VectorXd::Constant(1, x.sum()); }
+  Eigen::VectorXd gl() const { return Eigen::VectorXd::Ones(1); }
+  Eigen::VectorXd gu() const { return Eigen::VectorXd::Ones(1); }
+  Eigen::SparseMatrix<double> dg_dx(const Eigen::VectorXd &) const
+  {
+    return Eigen::MatrixXd::Ones(1, 2).sparseView();
+  }
+};
+
+/// @brief Rosenbrock function on the unit disk
+struct RosenbrockNLP
+{
+  std::size_t n() const { return 2; }
+  std::size_t m() const { return 1; }
+
+  Eigen::VectorXd xl() const { return Eigen::Vector2d::Constant(-std::numeric_limits<double>::infinity()); }
+  Eigen::VectorXd xu() const { return Eigen::Vector2d::Constant(std::numeric_limits<double>::infinity()); }
+
+  double f(const Eigen::VectorXd & x) const
+  {
+    return (1 - x(0)) * (1 - x(0)) + 100 * (x(1) - x(0) * x(0)) * (x(1) - x(0) * x(0));
+  }
+  Eigen::SparseMatrix<double> df_dx(const Eigen::VectorXd & x) const
+  {
+    Eigen::MatrixXd ret(1, 2);
+    ret << -2 * (1 - x(0)) - 400 * x(0) * (x(1) - x(0) * x(0)), 200 * (x(1) - x(0) * x(0));
+    return ret.sparseView();
+  }
+
+  Eigen::VectorXd g(const Eigen::VectorXd & x) const { return Eigen::VectorXd::Constant(1, x.squaredNorm()); }
+  Eigen::VectorXd gl() const { return Eigen::VectorXd::Constant(1, -std::numeric_limits<double>::infinity()); }
+  Eigen::VectorXd gu() const { return Eigen::VectorXd::Ones(1); }
+  Eigen::SparseMatrix<double> dg_dx(const Eigen::VectorXd & x) const
+  {
+    return Eigen::MatrixXd(2 * x.transpose()).sparseView();
+  }
+};
+
+TEST(NLPSolver, Quadratic)
+{
+  const auto sol = smooth::feedback::solve_nlp(QuadraticNLP{}, {.eps_abs = 1e-8, .delta_abs = 1e-8});
+
+  ASSERT_EQ(sol.status, smooth::feedback::NLPSolution::Status::Optimal);
+  ASSERT_TRUE(sol.x.isApprox(Eigen::Vector2d{0.3, 0.7}, 1e-6));
+  ASSERT_NEAR(sol.lambda(0), -1.4, 1e-5);
+  ASSERT_NEAR(sol.zl(0), 0, 1e-5);
+  ASSERT_NEAR(sol.zu(0), 0.8, 1e-5);
+  ASSERT_NEAR(sol.objective, 0.58, 1e-6);
+}
+
+TEST(NLPSolver, Rosenbrock)
+{
+  RosenbrockNLP nlp;
+
+  smooth::feedback::NLPSolver solver(nlp.n(), nlp.m());
+
+  const auto sol = solver.solve(nlp);
+
+  ASSERT_EQ(sol.status, smooth::feedback::NLPSolution::Status::Optimal);
+  ASSERT_NEAR(sol.x.norm(), 1, 1e-5);
+  ASSERT_NEAR(sol.x(0), 0.7864, 1e-3);
+  ASSERT_NEAR(sol.x(1), 0.6177, 1e-3);
+  ASSERT_GE(sol.lambda(0), 0);
+
+  // solve again with warmstart
+  const auto sol_warm = solver.solve(nlp, sol);
+
+  ASSERT_EQ(sol_warm.status, smooth::feedback::NLPSolution::Status::Optimal);
+  ASSERT_LE(sol_warm.iter, sol.iter);
+  ASSERT_TRUE(sol_warm.x.isApprox(sol.x, 1e-5));
+}
+
+TEST(NLPSolver, Limits)
+{
+  const auto sol = smooth::feedback::solve_nlp(RosenbrockNLP{}, {.max_iter = 2});
+  ASSERT_EQ(sol.status, smooth::feedback::NLPSolution::Status::MaxIterations);
+}
@@ -25,6 +25,7 @@
 
 #include <Eigen/Core>
 #include <gtest/gtest.h>
+#include <smooth/bundle.hpp>
 #include <smooth/compat/autodiff.hpp>
 
 #include "smooth/feedback/ocp_flatten.hpp"
@@ -58,3 +59,226 @@ TEST(OcpFlatten, Basic)
   const auto t2b = smooth::feedback::test_ocp_derivatives<DT>(ocp_flat, 5);
   ASSERT_TRUE(t2b);
 }
+
+TEST(OcpFlatten, LvalueReference)
+{
+  double rate = 1;
+
+  const auto xl = [&rate]<typename T>(const T & t) -> smooth::CastT<T, OcpTest::X> {
+    const Eigen::Vector<T, Nx> vel{T(rate), 2, 3};
+    return smooth::exp<smooth::CastT<T, OcpTest::X>>(t * vel);
+  };
+  const auto ul = []<typename T>(const T & t) -> smooth::CastT<T, OcpTest::U> {
+    const Eigen::Vector<T, Nu> vel{1, 2};
+    return smooth::exp<smooth::CastT<T, OcpTest::U>>(t * vel);
+  };
+
+  // lvalues are stored by reference
+  auto ocp_flat = smooth::feedback::flatten_ocp(ocp_test, xl, ul);
+
+  const double t                    = 0.5;
+  const Eigen::Vector<double, Nx> e = Eigen::Vector<double, Nx>::Random();
+  const Eigen::Vector<double, Nu> v = Eigen::Vector<double, Nu>::Random();
+
+  const Eigen::MatrixXd J1 = ocp_flat.f.jacobian(t, e, v).get();
+
+  rate                     = 2;
+  const Eigen::MatrixXd J2 = ocp_flat.f.jacobian(t, e, v).get();
+
+  auto ocp_new             = smooth::feedback::flatten_ocp(ocp_test, xl, ul);
+  const Eigen::MatrixXd J3 = ocp_new.f.jacobian(t, e, v).get();
+
+  ASSERT_FALSE(J1.isApprox(J2));
+  ASSERT_TRUE(J2.isApprox(J3));
+}
+
+TEST(OcpFlatten, Precomputed)
+{
+  std::size_t n_xl = 0;
+
+  const auto xl = [&n_xl]<typename T>(const T & t) -> smooth::CastT<T, OcpTest::X> {
+    ++n_xl;
+    const Eigen::Vector<T, Nx> vel{1, 2, 3};
+    return smooth::exp<smooth::CastT<T, OcpTest::X>>(t * vel);
+  };
+  const auto ul = []<typename T>(const T & t) -> smooth::CastT<T, OcpTest::U> {
+    const Eigen::Vector<T, Nu> vel{1, 2};
+    return smooth::exp<smooth::CastT<T, OcpTest::U>>(t * vel);
+  };
+
+  const double tf = 2.;
+  smooth::feedback::Mesh<3, 3> mesh;
+  mesh.refine_ph(0, 6);
+
+  auto ocp_flat = smooth::feedback::flatten_ocp(ocp_test, xl, ul);
+  auto ocp_pre  = smooth::feedback::flatten_ocp(ocp_test, xl, ul, mesh, tf);
+
+  const auto nodes = mesh.all_nodes();
+  const std::vector<double> taus(nodes.begin(), nodes.end());
+
+  const Eigen::Vector<double, Nx> e = Eigen::Vector<double, Nx>::Random();
+  const Eigen::Vector<double, Nu> v = Eigen::Vector<double, Nu>::Random();
+
+  // node times and a time between nodes give the same result
+  for (const double t : {tf * taus[0], tf * taus[2], tf * taus.back(), 0.123}) {
+    ASSERT_TRUE(ocp_pre.f(t, e, v).isApprox(ocp_flat.f(t, e, v)));
+    ASSERT_TRUE(ocp_pre.f.jacobian(t, e, v).get().isApprox(ocp_flat.f.jacobian(t, e, v).get()));
+    ASSERT_TRUE(ocp_pre.f.hessian(t, e, v).get().isApprox(ocp_flat.f.hessian(t, e, v).get()));
+    ASSERT_TRUE(ocp_pre.cr.jacobian(t, e, v).get().isApprox(ocp_flat.cr.jacobian(t, e, v).get()));
+  }
+
+  // node times do not evaluate xl
+  const std::size_t n_before = n_xl;
+  for (const double tau : taus) {
+    [[maybe_unused]] const auto f   = ocp_pre.f(tf * tau, e, v);
+    [[maybe_unused]] const auto & J = ocp_pre.f.jacobian(tf * tau, e, v);
+    [[maybe_unused]] const auto & H = ocp_pre.f.hessian(tf * tau, e, v);
+  }
+  ASSERT_EQ(n_xl, n_before);
+}
+
+TEST(OcpFlatten, SeriesTruncation)
+{
+  std::srand(5);
+
+  const auto xl = []<typename T>(const T & t) -> smooth::CastT<T, OcpTest::X> {
+    const Eigen::Vector<T, Nx> vel{1, 2, 3};
+    return smooth::exp<smooth::CastT<T, OcpTest::X>>(t * vel);
+  };
+  const auto ul = []<typename T>(const T & t) -> smooth::CastT<T, OcpTest::U> {
+    const Eigen::Vector<T, Nu> vel{1, 2};
+    return smooth::exp<smooth::CastT<T, OcpTest::U>>(t * vel);
+  };
+
+  auto ocp_trunc = smooth::feedback::flatten_ocp(ocp_test, xl, ul);
+  auto ocp_full  = smooth::feedback::flatten_ocp(ocp_test, xl, ul);
+  ocp_full.f.set_series_tol(0);
+
+  const double t = 0.5;
+
+  for (const double scale : {1e-4, 1e-2, 1.}) {
+    const Eigen::Vector<double, Nx> e = scale * Eigen::Vector<double, Nx>::Random();
+    const Eigen::Vector<double, Nu> v = Eigen::Vector<double, Nu>::Random();
+
+    const Eigen::MatrixXd H_trunc = ocp_trunc.f.hessian(t, e, v).get();
+    const Eigen::MatrixXd H_full  = ocp_full.f.hessian(t, e, v).get();
+
+    ASSERT_LE((H_trunc - H_full).cwiseAbs().maxCoeff(), 1e-9);
+    ASSERT_EQ(ocp_full.f.series_terms(), 23u);
+    if (scale < 1e-1) { ASSERT_LT(ocp_trunc.f.series_terms(), 23u); }
+  }
+}
+
+template<typename T>
+using XBig = smooth::Bundle<smooth::SE2<T>, Eigen::Vector<T, 12>>;
+
+/// @brief Dynamics with 1 + Nx + Nu > kFlatDynDenseMaxVars
+struct BigDyn
+{
+  template<typename T>
+  smooth::Tangent<XBig<T>> operator()(T, const XBig<T> & x, const U<T> & u) const
+  {
+    smooth::Tangent<XBig<T>> ret;
+    ret(0) = u.x() - 0.1 * x.template part<0>().r2().x();
+    ret(1) = 0;
+    ret(2) = u.y();
+    for (auto i = 0u; i < 12; ++i) {
+      ret(3 + i) = -0.5 * x.template part<1>()(i) + 0.1 * x.template part<1>()((i + 1) % 12) * u.x();
+    }
+    return ret;
+  }
+
+  Eigen::SparseMatrix<double> jacobian(double t, const XBig<double> & x, const U<double> & u) const
+  {
+    const auto [fval, df] = smooth::diff::dr<1>(*this, smooth::wrt(t, x, u));
+    return df.sparseView();
+  }
+
+  Eigen::SparseMatrix<double> hessian(double t, const XBig<double> & x, const U<double> & u) const
+  {
+    const auto [fval, df, d2f] = smooth::diff::dr<2>(*this, smooth::wrt(t, x, u));
+    return d2f.sparseView();
+  }
+};
+
+TEST(OcpFlatten, SparseKernel)
+{
+  std::srand(3);
+
+  using XB = XBig<double>;
+  using UB = U<double>;
+
+  static constexpr auto NxB = smooth::Dof<XB>;
+  static_assert(1 + NxB + Nu > smooth::feedback::detail::kFlatDynDenseMaxVars);
+
+  const auto xl = []<typename T>(const T & t) -> smooth::CastT<T, XB> {
+    const Eigen::Vector<T, NxB> vel = Eigen::Vector<T, NxB>::Ones();
+    return smooth::exp<smooth::CastT<T, XB>>(t * vel);
+  };
+  const auto ul = []<typename T>(const T & t) -> smooth::CastT<T, UB> {
+    const Eigen::Vector<T, Nu> vel{1, 2};
+    return smooth::exp<smooth::CastT<T, UB>>(t * vel);
+  };
+
+  using Ref = smooth::feedback::detail::FlatReference<XB, UB, decltype(xl), decltype(ul)>;
+  const auto ref = std::make_shared<const Ref>(xl, ul);
+
+  smooth::feedback::detail::FlatDyn<XB, UB, BigDyn, Ref, true> f_dense(BigDyn{}, ref);
+  smooth::feedback::detail::FlatDyn<XB, UB, BigDyn, Ref, false> f_sparse(BigDyn{}, ref);
+
+  const double t = 0.5;
+
+  // evaluate twice to catch allocation/compression issues (first call allocates)
+  for (auto i = 0u; i < 2; ++i) {
+    const Eigen::Vector<double, NxB> e = 0.1 * Eigen::Vector<double, NxB>::Random();
+    const Eigen::Vector<double, Nu> v  = Eigen::Vector<double, Nu>::Random();
+
+    const Eigen::MatrixXd J_dense  = f_dense.jacobian(t, e, v).get();
+    const Eigen::MatrixXd J_sparse = f_sparse.jacobian(t, e, v).get();
+    ASSERT_TRUE(J_sparse.isApprox(J_dense, 1e-10));
+
+    const Eigen::MatrixXd H_dense  = f_dense.hessian(t, e, v).get();
+    const Eigen::MatrixXd H_sparse = f_sparse.hessian(t, e, v).get();
+    ASSERT_LE((H_sparse - H_dense).cwiseAbs().maxCoeff(), 1e-10);
+  }
+}
+
+TEST(OcpFlatten, SeriesTruncationSparse)
+{
+  std::srand(7);
+
+  using XB = XBig<double>;
+  using UB = U<double>;
+
+  static constexpr auto NxB = smooth::Dof<XB>;
+
+  const auto xl = []<typename T>(const T & t) -> smooth::CastT<T, XB> {
+    const Eigen::Vector<T, NxB> vel = Eigen::Vector<T, NxB>::Ones();
+    return smooth::exp<smooth::CastT<T, XB>>(t * vel);
+  };
+  const auto ul = []<typename T>(const T & t) -> smooth::CastT<T, UB> {
+    const Eigen::Vector<T, Nu> vel{1, 2};
+    return smooth::exp<smooth::CastT<T, UB>>(t * vel);
+  };
+
+  using Ref = smooth::feedback::detail::FlatReference<XB, UB, decltype(xl), decltype(ul)>;
+  const auto ref = std::make_shared<const Ref>(xl, ul);
+
+  smooth::feedback::detail::FlatDyn<XB, UB, BigDyn, Ref> f_trunc(BigDyn{}, ref);
+  smooth::feedback::detail::FlatDyn<XB, UB, BigDyn, Ref> f_full(BigDyn{}, ref);
+  f_full.set_series_tol(0);
+
+  const double t = 0.5;
+
+  for (const double scale : {1e-4, 1e-2, 1.}) {
+    const Eigen::Vector<double, NxB> e = scale * Eigen::Vector<double, NxB>::Random();
+    const Eigen::Vector<double, Nu> v  = Eigen::Vector<double, Nu>::Random();
+
+    const Eigen::MatrixXd H_trunc = f_trunc.hessian(t, e, v).get();
+    const Eigen::MatrixXd H_full  = f_full.hessian(t, e, v).get();
+
+    ASSERT_LE((H_trunc - H_full).cwiseAbs().maxCoeff(), 1e-9);
+    ASSERT_EQ(f_full.series_terms(), 23u);
+    if (scale < 1e-1) { ASSERT_LT(f_trunc.series_terms(), 23u); }
+  }
+}
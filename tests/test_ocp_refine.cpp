@@ -0,0 +1,112 @@
+// smooth_feedback: Control theory on Lie groups
+// https://github.com/pettni/smooth_feedback
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+// Copyright (c) 2021 Petter Nilsson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <Eigen/Core>
+#include <gtest/gtest.h>
+
+#include "smooth/feedback/ocp_refine.hpp"
+
+template<typename T, std::size_t N>
+using Vec = Eigen::Vector<T, N>;
+
+namespace {
+
+// minimum-energy double integrator from (1, 0) to (0, 0) in unit time
+auto make_ocp()
+{
+  auto theta = []<typename T>(T, Vec<T, 2>, Vec<T, 2>, Vec<T, 1> q) -> T { return q.x(); };
+  auto f     = []<typename T>(T, Vec<T, 2> x, Vec<T, 1> u) -> Vec<T, 2> { return Vec<T, 2>{{x.y(), u.x()}}; };
+  auto g     = []<typename T>(T, Vec<T, 2>, Vec<T, 1> u) -> Vec<T, 1> { return Vec<T, 1>{{u.squaredNorm()}}; };
+  auto cr    = []<typename T>(T, Vec<T, 2>, Vec<T, 1> u) -> Vec<T, 1> { return u; };
+  auto ce    = []<typename T>(T tf, Vec<T, 2> x0, Vec<T, 2> xf, Vec<T, 1>) -> Vec<T, 5> {
+    Vec<T, 5> ret(5);
+    ret << tf, x0, xf;
+    return ret;
+  };
+
+  return smooth::feedback::
+    OCP<Vec<double, 2>, Vec<double, 1>, decltype(theta), decltype(f), decltype(g), decltype(cr), decltype(ce)>{
+      .theta = theta,
+      .f     = f,
+      .g     = g,
+      .cr    = cr,
+      .crl   = Vec<double, 1>{{-20}},
+      .cru   = Vec<double, 1>{{20}},
+      .ce    = ce,
+      .cel   = Vec<double, 5>{{1, 1, 0, 0, 0}},
+      .ceu   = Vec<double, 5>{{1, 1, 0, 0, 0}},
+    };
+}
+
+}  // namespace
+
+TEST(OcpRefine, NLPSolver)
+{
+  const auto ocp = make_ocp();
+
+  smooth::feedback::Mesh<3, 6> mesh;
+  smooth::feedback::NLPSolver solver({.eps_abs = 1e-8, .delta_abs = 1e-8, .max_outer_iter = 200});
+
+  std::size_t n_calls = 0;
+
+  const auto res = smooth::feedback::solve_ocp_refine(
+    ocp,
+    mesh,
+    solver,
+    {.target_err = 1e-4, .max_iter = 5, .n_threads = 2},
+    {},
+    [&n_calls](std::size_t iter, const auto &, const auto &, const Eigen::VectorXd &) { ASSERT_EQ(iter, n_calls++); });
+
+  ASSERT_EQ(n_calls, res.iter);
+  ASSERT_TRUE(res.converged);
+  ASSERT_EQ(res.errs.size(), static_cast<Eigen::Index>(mesh.N_ivals()));
+  ASSERT_LE(res.errs.maxCoeff(), 1e-4);
+
+  // analytical solution u(t) = 12 t - 6, x(t) = 1 - 3 t^2 + 2 t^3
+  ASSERT_NEAR(res.ocpsol.tf, 1, 1e-4);
+  for (const double t : {0.1, 0.4, 0.75}) {
+    ASSERT_NEAR(res.ocpsol.u(t).x(), 12 * t - 6, 1e-2);
+    ASSERT_NEAR(res.ocpsol.x(t).x(), 1 - 3 * t * t + 2 * t * t * t, 1e-3);
+  }
+}
+
+TEST(OcpRefine, Budget)
+{
+  const auto ocp = make_ocp();
+
+  smooth::feedback::Mesh<3, 3> mesh;
+
+  const auto solver = [](auto & nlp, const std::optional<smooth::feedback::NLPSolution> & warmstart) {
+    if (warmstart.has_value()) { return smooth::feedback::solve_nlp(nlp, {.max_iter = 5}, std::cref(*warmstart)); }
+    return smooth::feedback::solve_nlp(nlp, {.max_iter = 5});
+  };
+
+  // impossible target with a tight node budget
+  const auto res = smooth::feedback::solve_ocp_refine(ocp, mesh, solver, {.target_err = 1e-16, .max_colloc = 12});
+
+  ASSERT_FALSE(res.converged);
+  ASSERT_LE(mesh.N_colloc(), 12u);
+  ASSERT_EQ(res.errs.size(), static_cast<Eigen::Index>(mesh.N_ivals()));
+}
@@ -107,4 +107,20 @@ TEST(OcpToNlp, Derivatives2)
   ASSERT_TRUE(Eigen::MatrixXd(dg_dx).isApprox(dg_dx_num, 1e-4));
   ASSERT_TRUE(Eigen::MatrixXd(Eigen::MatrixXd(d2f_dx2).selfadjointView<Eigen::Upper>()).isApprox(d2f_dx2_num, 1e-3));
   ASSERT_TRUE(Eigen::MatrixXd(Eigen::MatrixXd(d2g_dx2).selfadjointView<Eigen::Upper>()).isApprox(d2g_dx2_num, 1e-3));
+
+  // Compressed finite differences
+  const Eigen::MatrixXd dg_dx_an = dg_dx;
+
+  const Eigen::MatrixXd pattern = smooth::feedback::detail::ocp_nlp_dg_dx_pattern(ocp, mesh);
+  ASSERT_EQ(((dg_dx_an.array() != 0) && (pattern.array() == 0)).count(), 0);
+  ASSERT_LT(smooth::feedback::cpr_coloring(smooth::feedback::detail::ocp_nlp_dg_dx_pattern(ocp, mesh, false)).first,
+            static_cast<Eigen::Index>(nlp.n()));
+
+  ASSERT_TRUE(Eigen::MatrixXd(nlp.dg_dx_cpr(x)).isApprox(dg_dx_an, 1e-4));
+  ASSERT_TRUE(Eigen::MatrixXd(nlp.dg_dx_cpr(x, 4)).isApprox(dg_dx_an, 1e-4));
+  ASSERT_TRUE(Eigen::MatrixXd(nlp.dg_dx_cpr(x, 4)).isApprox(dg_dx_an, 1e-4));  // re-uses thread copies
+
+  // numerical differentiation uses compressed finite differences
+  auto nlp_num = smooth::feedback::ocp_to_nlp<smooth::diff::Type::Numerical>(ocp, mesh);
+  ASSERT_TRUE(Eigen::MatrixXd(nlp_num.dg_dx(x)).isApprox(dg_dx_an, 1e-4));
 }
@@ -28,6 +28,7 @@
 
 #include "smooth/feedback/ocp.hpp"
 #include "smooth/feedback/ocp_to_qp.hpp"
+#include "smooth/feedback/qp_solver.hpp"
 
 template<typename T>
 using X = Eigen::Vector<T, 2>;
@@ -105,3 +106,72 @@ TEST(OcpToQp, Basic)
   ASSERT_GE((qp.A * var - qp.l).minCoeff(), -1e-8);
   ASSERT_GE((qp.u - qp.A * var).minCoeff(), -1e-8);
 }
+
+TEST(OcpToQp, Condensed)
+{
+  const auto theta = []<typename T>(T, X<T>, X<T> xf, Vec<T, 1> q) -> T { return xf.squaredNorm() + 2 * q.sum(); };
+
+  const auto f = []<typename T>(T, X<T> x, U<T> u) -> smooth::Tangent<X<T>> { return {x.y(), u.x()}; };
+
+  const auto g = []<typename T>(T, X<T>, U<T> u) -> Vec<T, 1> { return Vec<T, 1>{{u.x() * u.x()}}; };
+
+  const auto cr = []<typename T>(T, X<T>, U<T> u) -> Vec<T, 1> { return Vec<T, 1>{{u.x()}}; };
+
+  const auto ce = []<typename T>(T, X<T> x0, X<T>, Vec<T, 1>) -> Vec<T, 2> { return x0; };
+
+  smooth::feedback::OCP<X<double>, U<double>, decltype(theta), decltype(f), decltype(g), decltype(cr), decltype(ce)>
+    ocp{
+      .theta = theta,
+      .f     = f,
+      .g     = g,
+      .cr    = cr,
+      .crl   = Eigen::VectorXd{{-1}},
+      .cru   = Eigen::VectorXd{{1}},
+      .ce    = ce,
+      .cel   = Eigen::Vector2d{1, 0.5},
+      .ceu   = Eigen::Vector2d{1, 0.5},
+    };
+
+  smooth::feedback::Mesh<5, 5> mesh;
+  mesh.refine_ph(0, 10);
+
+  constexpr auto tf = 2.;
+
+  const auto xl_fun = []<typename T>(T t) -> X<T> { return X<T>{{0.05 * t * t, 0.1 * t}}; };
+  const auto ul_fun = []<typename T>(T) -> U<T> { return U<T>{{0.1}}; };
+
+  const auto qp  = smooth::feedback::ocp_to_qp(ocp, mesh, tf, xl_fun, ul_fun);
+  const auto cqp = smooth::feedback::ocp_to_qp_condensed(ocp, mesh, tf, xl_fun, ul_fun);
+
+  const auto N = static_cast<Eigen::Index>(mesh.N_colloc());
+
+  ASSERT_EQ(cqp.qp.P.rows(), ocp.Nx + ocp.Nu * N);
+  ASSERT_EQ(cqp.qp.A.cols(), ocp.Nx + ocp.Nu * N);
+  ASSERT_EQ(cqp.qp.A.rows(), qp.A.rows() - ocp.Nx * N);
+  ASSERT_EQ(cqp.T.rows(), qp.A.cols());
+
+  // expanded variables satisfy dynamics constraints
+  const Eigen::VectorXd y = Eigen::VectorXd::Random(cqp.qp.A.cols());
+  const Eigen::VectorXd z = cqp.T * y + cqp.c;
+  ASSERT_LE((qp.A.topRows(ocp.Nx * N) * z - qp.l.head(ocp.Nx * N)).cwiseAbs().maxCoeff(), 1e-8);
+
+  // solutions agree
+  const smooth::feedback::QPSolverParams prm{.eps_abs = 1e-6f, .eps_rel = 1e-6f};
+
+  const auto sol      = smooth::feedback::solve_qp(qp, prm);
+  const auto csol     = smooth::feedback::solve_qp(cqp.qp, prm);
+  const auto csol_exp = smooth::feedback::qpsol_expand(cqp, csol);
+
+  ASSERT_EQ(sol.code, smooth::feedback::QPSolutionStatus::Optimal);
+  ASSERT_EQ(csol.code, smooth::feedback::QPSolutionStatus::Optimal);
+
+  ASSERT_EQ(csol_exp.primal.size(), sol.primal.size());
+  ASSERT_EQ(csol_exp.dual.size(), sol.dual.size());
+  ASSERT_TRUE(csol_exp.primal.isApprox(sol.primal, 1e-3));
+  ASSERT_NEAR(csol_exp.objective, sol.objective, 1e-3 * (1 + std::abs(sol.objective)));
+
+  // recovered dynamics multipliers and remaining multipliers agree
+  const auto dcon_L = ocp.Nx * N;
+  ASSERT_TRUE(csol_exp.dual.head(dcon_L).isApprox(sol.dual.head(dcon_L), 1e-2));
+  ASSERT_TRUE(csol_exp.dual.isApprox(sol.dual, 1e-2));
+}
@@ -91,3 +91,53 @@ TEST(PID, SetDesiredCurve)
     ASSERT_TRUE(u.isApprox(u_expected));
   }
 }
+
+TEST(PID, SplineReference)
+{
+  using Time = std::chrono::duration<double>;
+  using Ref  = smooth::feedback::SplineReference<3, smooth::SE2d, Time>;
+
+  std::vector<double> tt{0, 1, 2, 3, 4, 5};
+  std::vector<smooth::SE2d> gg(tt.size());
+  for (auto & g : gg) { g = smooth::SE2d::Random(); }
+
+  const auto c = smooth::fit_spline_cubic(tt, gg);
+
+  Ref ref(0.5s, c, 0.7);
+
+  // monotone, backwards, and outside of curve
+  for (double t : {0., 0.5, 0.6, 1.2, 1.21, 2.5, 4.5, 1.0, 3.3, 5.5, 6.0, 10.0}) {
+    const auto [g_des, v_des, a_des] = ref(Time(t));
+
+    Eigen::Vector3d v_exp, a_exp;
+    const smooth::SE2d g_exp = c(t - 0.5, v_exp, a_exp);
+
+    ASSERT_LE((g_des - g_exp).norm(), 1e-8);
+    ASSERT_LE((v_des - v_exp).norm(), 1e-8);
+    ASSERT_LE((a_des - a_exp).norm(), 1e-8);
+  }
+
+  // as template parameter
+  smooth::feedback::PID<Time, smooth::SE2d, Ref> pid(Ref(0.5s, c));
+  pid.set_kp(2);
+  pid.set_kd(3);
+
+  const smooth::SE2d g    = smooth::SE2d::Random();
+  const Eigen::Vector3d v = Eigen::Vector3d::Random();
+
+  Eigen::Vector3d v_des, a_des;
+  const auto g_des = c(0.5, v_des, a_des);
+
+  const Eigen::Vector3d u          = pid(1s, g, v);
+  const Eigen::Vector3d u_expected = a_des + 3 * (v_des - v) + 2 * (g_des - g);
+
+  ASSERT_TRUE(u.isApprox(u_expected));
+
+  // type-erased reference evaluates the curve directly
+  smooth::feedback::PID<Time, smooth::SE2d> pid_fun;
+  pid_fun.set_kp(2);
+  pid_fun.set_kd(3);
+  pid_fun.set_xdes(0.5s, c);
+
+  ASSERT_TRUE(pid_fun(1s, g, v).isApprox(u_expected));
+}
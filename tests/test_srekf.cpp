@@ -0,0 +1,200 @@
+// smooth_feedback: Control theory on Lie groups
+// https://github.com/pettni/smooth_feedback
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+//
+// Copyright (c) 2021 Petter Nilsson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gtest/gtest.h>
+#include <smooth/feedback/ekf.hpp>
+#include <smooth/feedback/srekf.hpp>
+#include <smooth/so3.hpp>
+#include <unsupported/Eigen/MatrixFunctions>
+
+TEST(SrEkf, NoCrash)
+{
+  smooth::feedback::SquareRootEKF<smooth::SO3d> ekf;
+
+  ekf.reset(smooth::SO3d::Identity(), Eigen::Matrix3d::Identity());
+
+  const auto dyn = []<typename T>(T, const smooth::SO3<T> &) -> Eigen::Vector3<T> {
+    return Eigen::Vector3<T>::UnitX();
+  };
+  Eigen::Matrix3d Q = Eigen::Matrix3d::Identity();
+  const auto meas   = []<typename T>(const smooth::SO3<T> & g) -> Eigen::Vector3<T> {
+    return g * Eigen::Vector3<T>::UnitZ();
+  };
+
+  ASSERT_NO_THROW(ekf.predict(dyn, Q, 1, 0.6););
+  ASSERT_NO_THROW(ekf.update(meas, Eigen::Vector3d::UnitY(), Q););
+  ASSERT_NO_THROW(ekf.predict(dyn, Q, 1, 0.1););
+}
+
+template<int Nx, int Ny>
+void test_srekf_update_linear()
+{
+  for (auto it = 0; it != 10; ++it) {
+    Eigen::Matrix<double, Nx, 1> x    = Eigen::Matrix<double, Nx, 1>::Random();
+    Eigen::Matrix<double, Nx, 1> xhat = Eigen::Matrix<double, Nx, 1>::Random();
+
+    smooth::feedback::SquareRootEKF<Eigen::Matrix<double, Nx, 1>> ekf;
+
+    const Eigen::Matrix<double, Nx, Nx> B = Eigen::Matrix<double, Nx, Nx>::Random();
+    const Eigen::Matrix<double, Nx, Nx> P = B * B.transpose() + Eigen::Matrix<double, Nx, Nx>::Identity();
+
+    ekf.reset(xhat, P);
+    ASSERT_TRUE(ekf.covariance().isApprox(P, 1e-10));
+
+    // measurement model
+    Eigen::Matrix<double, Ny, Nx> H = Eigen::Matrix<double, Ny, Nx>::Random();
+    Eigen::Matrix<double, Ny, 1> h  = Eigen::Matrix<double, Ny, 1>::Random();
+    Eigen::Matrix<double, Ny, Ny> R = Eigen::Matrix<double, Ny, 1>::Random().asDiagonal();
+    R.diagonal() += Eigen::Matrix<double, Ny, 1>::Constant(1.1);
+
+    ekf.update(
+      [&H, &h]<typename T>(const Eigen::Matrix<T, Nx, 1> & xvar) -> Eigen::Matrix<T, Ny, 1> { return H * xvar + h; },
+      H * x + h,
+      R);
+
+    // kalman update for linear system
+    Eigen::Matrix<double, Ny, Ny> S = H * P * H.transpose() + R;
+    Eigen::Matrix<double, Nx, Ny> K = P * H.transpose() * S.inverse();
+
+    Eigen::Matrix<double, Nx, 1> x_new  = xhat + K * (H * x - H * xhat);
+    Eigen::Matrix<double, Nx, Nx> P_new = (Eigen::Matrix<double, Nx, Nx>::Identity() - K * H) * P;
+
+    ASSERT_TRUE(x_new.isApprox(ekf.estimate(), 1e-6));
+    ASSERT_TRUE(P_new.isApprox(ekf.covariance(), 1e-6));
+
+    // square root is lower triangular
+    ASSERT_TRUE(ekf.sqrt_covariance().template triangularView<Eigen::StrictlyUpper>().toDenseMatrix().isZero());
+  }
+}
+
+TEST(SrEkf, UpdateLinear)
+{
+  test_srekf_update_linear<3, 3>();
+  test_srekf_update_linear<10, 3>();
+  test_srekf_update_linear<3, 10>();
+  test_srekf_update_linear<15, 6>();
+}
+
+template<int Nx>
+void test_srekf_predict_linear()
+{
+  for (auto it = 0; it != 10; ++it) {
+    Eigen::Matrix<double, Nx, 1> xhat = Eigen::Matrix<double, Nx, 1>::Random();
+
+    smooth::feedback::
+      SquareRootEKF<Eigen::Matrix<double, Nx, 1>, smooth::diff::Type::Numerical, boost::numeric::odeint::runge_kutta4>
+        ekf;
+
+    Eigen::Matrix<double, Nx, Nx> P = Eigen::Matrix<double, Nx, 1>::Random().asDiagonal();
+    P.diagonal() += Eigen::Matrix<double, Nx, 1>::Constant(1.1);
+
+    ekf.reset(xhat, P);
+
+    Eigen::Matrix<double, Nx, Nx> A = Eigen::Matrix<double, Nx, Nx>::Random();
+    Eigen::Matrix<double, Nx, Nx> Q = Eigen::Matrix<double, Nx, Nx>::Zero();
+
+    double tau = 0.7;
+
+    ekf.predict(
+      [&A]<typename T>(double, const Eigen::Matrix<T, Nx, 1> & xvar) -> Eigen::Matrix<T, Nx, 1> { return A * xvar; },
+      Q,
+      tau,
+      1e-2);
+
+    // exact solution
+    Eigen::Matrix<double, Nx, Nx> F       = (A * tau).exp();
+    Eigen::Matrix<double, Nx, 1> xhat_new = F * xhat;
+    Eigen::Matrix<double, Nx, Nx> P_new   = F * P * F.transpose();
+
+    ASSERT_TRUE(xhat_new.isApprox(ekf.estimate(), 1e-3));
+    ASSERT_TRUE(P_new.isApprox(ekf.covariance(), 1e-3));
+  }
+}
+
+TEST(SrEkf, PredictLinear)
+{
+  test_srekf_predict_linear<3>();
+  test_srekf_predict_linear<6>();
+  test_srekf_predict_linear<15>();
+}
+
+TEST(SrEkf, CompareEkf)
+{
+  // random walk with process noise on a Lie group
+  const auto dyn = []<typename T>(T t, const smooth::SO3<T> &) -> Eigen::Vector3<T> {
+    return Eigen::Vector3<T>(T(1), T(0.5) * t, T(-0.2));
+  };
+  const auto meas = []<typename T>(const smooth::SO3<T> & g) -> Eigen::Vector3<T> {
+    return g * Eigen::Vector3<T>::UnitZ();
+  };
+
+  const Eigen::Matrix3d Q = Eigen::Vector3d(0.1, 0.2, 0.3).asDiagonal();
+  const Eigen::Matrix3d R = 0.05 * Eigen::Matrix3d::Identity();
+
+  smooth::feedback::EKF<smooth::SO3d> ekf;
+  smooth::feedback::SquareRootEKF<smooth::SO3d> srekf;
+
+  const smooth::SO3d g0 = smooth::SO3d::Random();
+  ekf.reset(g0, Eigen::Matrix3d::Identity());
+  srekf.reset(g0, Eigen::Matrix3d::Identity());
+
+  for (auto i = 0u; i < 5; ++i) {
+    ekf.predict(dyn, Q, 0.5, 1e-3);
+    srekf.predict(dyn, Q, 0.5, 1e-3);
+
+    ASSERT_LE((ekf.estimate() - srekf.estimate()).norm(), 1e-6);
+    ASSERT_LE((ekf.covariance() - srekf.covariance()).norm(), 1e-2);
+
+    ekf.update(meas, Eigen::Vector3d::UnitY(), R);
+    srekf.update(meas, Eigen::Vector3d::UnitY(), R);
+
+    ASSERT_LE((ekf.estimate() - srekf.estimate()).norm(), 1e-2);
+    ASSERT_LE((ekf.covariance() - srekf.covariance()).norm(), 1e-2);
+  }
+}
+
+TEST(SrEkf, PredictDiscrete)
+{
+  const auto dyn = []<typename T>(T, const smooth::SO3<T> & g) -> Eigen::Vector3<T> {
+    return Eigen::Vector3<T>(T(1), T(0.2), T(0)) + T(0.1) * g.log();
+  };
+
+  const Eigen::Matrix3d Q = Eigen::Vector3d(0.1, 0.2, 0.3).asDiagonal();
+
+  smooth::feedback::EKF<smooth::SO3d> ekf;
+  smooth::feedback::SquareRootEKF<smooth::SO3d> srekf;
+
+  const smooth::SO3d g0 = smooth::SO3d::Random();
+  ekf.reset(g0, Eigen::Matrix3d::Identity());
+  srekf.reset(g0, Eigen::Matrix3d::Identity());
+
+  for (auto i = 0u; i < 3; ++i) {
+    ekf.predict_discrete(dyn, Q, 0.1);
+    srekf.predict_discrete(dyn, Q, 0.1);
+
+    ASSERT_LE((ekf.estimate() - srekf.estimate()).norm(), 1e-10);
+    ASSERT_TRUE(ekf.covariance().isApprox(srekf.covariance(), 1e-10));
+  }
+}
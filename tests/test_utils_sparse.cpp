@@ -25,7 +25,11 @@
 
 #include <gtest/gtest.h>
 
+#include <array>
+#include <span>
+
 #include "smooth/feedback/utils/sparse.hpp"
+#include "smooth/feedback/utils/thread_pool.hpp"
 
 TEST(Utils, BlockAdd)
 {
@@ -48,3 +52,95 @@ TEST(Utils, BlockAdd)
   ASSERT_TRUE(dest_d.bottomRightCorner(5, 5).isApprox(source2.rightCols(5)));
   ASSERT_TRUE(dest_d.bottomLeftCorner(5, 5).isApprox(Eigen::MatrixXd::Zero(5, 5)));
 }
+
+TEST(Utils, CprColoring)
+{
+  // block-tridiagonal pattern
+  Eigen::SparseMatrix<double> pattern(12, 12);
+  for (auto i = 0; i < 12; ++i) {
+    for (auto j = std::max(0, i - 1); j < std::min(12, i + 2); ++j) { pattern.insert(i, j) = 1; }
+  }
+
+  const auto [n_colors, colors] = smooth::feedback::cpr_coloring(pattern);
+
+  ASSERT_EQ(n_colors, 3);
+
+  // columns of the same color do not share rows
+  const Eigen::MatrixXd P = pattern;
+  for (auto j1 = 0; j1 < 12; ++j1) {
+    for (auto j2 = j1 + 1; j2 < 12; ++j2) {
+      if (colors(j1) == colors(j2)) { ASSERT_EQ(P.col(j1).dot(P.col(j2)), 0); }
+    }
+  }
+}
+
+TEST(Utils, FdJacobianColored)
+{
+  const auto f = [](const Eigen::VectorXd & x) -> Eigen::VectorXd {
+    Eigen::VectorXd ret(x.size());
+    for (auto i = 0; i < x.size(); ++i) {
+      ret(i) = x(i) * x(i);
+      if (i > 0) { ret(i) += std::sin(x(i - 1)); }
+      if (i + 1 < x.size()) { ret(i) -= x(i) * x(i + 1); }
+    }
+    return ret;
+  };
+
+  const Eigen::VectorXd x = Eigen::VectorXd::Random(20);
+
+  Eigen::MatrixXd J_an = Eigen::MatrixXd::Zero(20, 20);
+  for (auto i = 0; i < 20; ++i) {
+    J_an(i, i) = 2 * x(i);
+    if (i > 0) { J_an(i, i - 1) = std::cos(x(i - 1)); }
+    if (i + 1 < 20) {
+      J_an(i, i) -= x(i + 1);
+      J_an(i, i + 1) = -x(i);
+    }
+  }
+
+  Eigen::SparseMatrix<double> J = J_an.sparseView();
+  J.makeCompressed();
+  const auto coloring = smooth::feedback::cpr_coloring(J);
+  ASSERT_EQ(coloring.first, 3);
+
+  smooth::feedback::set_zero(J);
+  smooth::feedback::fd_jacobian_colored(f, x, coloring, J);
+  ASSERT_TRUE(Eigen::MatrixXd(J).isApprox(J_an, 1e-6));
+
+  smooth::feedback::ThreadPool pool(3);
+
+  smooth::feedback::set_zero(J);
+  smooth::feedback::fd_jacobian_colored(f, x, coloring, J, &pool);
+  ASSERT_TRUE(Eigen::MatrixXd(J).isApprox(J_an, 1e-6));
+
+  // one function object per thread, pool re-used between calls
+  std::array<decltype(f), 3> fs{f, f, f};
+  for (auto i = 0u; i < 2; ++i) {
+    smooth::feedback::set_zero(J);
+    smooth::feedback::fd_jacobian_colored(std::span(fs), x, coloring, J, &pool);
+    ASSERT_TRUE(Eigen::MatrixXd(J).isApprox(J_an, 1e-6));
+  }
+
+  // more threads than function objects
+  smooth::feedback::ThreadPool pool5(5);
+  smooth::feedback::set_zero(J);
+  smooth::feedback::fd_jacobian_colored(std::span(fs).first(2), x, coloring, J, &pool5);
+  ASSERT_TRUE(Eigen::MatrixXd(J).isApprox(J_an, 1e-6));
+}
+
+TEST(Utils, ThreadPool)
+{
+  smooth::feedback::ThreadPool pool(4);
+  ASSERT_EQ(pool.size(), 4);
+
+  std::array<std::size_t, 4> calls{};
+  for (auto i = 0u; i < 10; ++i) {
+    pool.run([&](std::size_t th) { ++calls[th]; });
+  }
+  for (const auto c : calls) { ASSERT_EQ(c, 10); }
+
+  smooth::feedback::ThreadPool serial(0);
+  ASSERT_EQ(serial.size(), 1);
+  serial.run([&](std::size_t th) { ++calls[th]; });
+  ASSERT_EQ(calls[0], 11);
+}